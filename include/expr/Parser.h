@@ -216,13 +216,16 @@ namespace expr {
     virtual unsigned GetNumErrors() const = 0;
 
     /// ParseTopLevelDecl - Parse and return a top level declaration,
-    /// which the caller assumes ownership of.
+    /// which the caller assumes ownership of. The later declarations do
+    /// not refer to it, so that it can be deleted right away when the
+    /// input is processed one declaration at a time.
     ///
     /// \return NULL indicates the end of the file has been reached.
     virtual Decl *ParseTopLevelDecl() = 0;
 
     /// CreateParser - Create a parser implementation for the given
-    /// MemoryBuffer.
+    /// MemoryBuffer. The input is either in the kquery language, or a
+    /// binary stream written by ExprSerializer.
     ///
     /// \arg Name - The name to use in diagnostic messages.
     /// \arg MB - The input data.
@@ -29,6 +29,8 @@ extern llvm::cl::opt<bool> UseForkedCoreSolver;
 
 extern llvm::cl::opt<bool> CoreSolverOptimizeDivides;
 
+extern llvm::cl::opt<unsigned> LookupTableMaxRuns;
+
 ///The different query logging solvers that can switched on/off
 enum QueryLoggingSolverType
 {
@@ -49,12 +51,17 @@ enum CoreSolverType {
   METASMT_SOLVER,
   DUMMY_SOLVER,
   Z3_SOLVER,
+  SMTLIB_SOLVER,
   NO_SOLVER
 };
 extern llvm::cl::opt<CoreSolverType> CoreSolverToUse;
 
 extern llvm::cl::opt<CoreSolverType> DebugCrossCheckCoreSolverWith;
 
+extern llvm::cl::opt<std::string> SMTLIBSolverCommand;
+
+extern llvm::cl::opt<unsigned> SMTLIBSolverPoolSize;
+
 #ifdef ENABLE_METASMT
 
 enum MetaSMTBackendType
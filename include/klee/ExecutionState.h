@@ -15,6 +15,7 @@
 #include "klee/Constraints.h"
 #include "klee/Expr.h"
 #include "klee/AllocationRecord.h"
+#include "klee/PendingAllocations.h"
 #include "klee/Internal/ADT/TreeStream.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 
@@ -178,6 +179,10 @@ private:
   std::list< ref<RecoveryInfo> > pendingRecoveryInfos;
   /* TODO: add docs */
   RecoveryCache recoveryCache;
+  /* allocations of recovery states, shared with the other dependent states */
+  ref<PendingAllocations> pendingAllocations;
+  /* how many of the pending allocations were already bound to this state */
+  unsigned int pendingAllocationsIndex;
 
   /* recovery state properties */
 
@@ -262,6 +267,11 @@ public:
   // FIXME: Move to a shared list structure (not critical).
   std::vector<std::pair<const MemoryObject *, const Array *> > symbolics;
 
+  /// @brief The index of each symbolic array within its object: objects
+  /// split by executeMakeSymbolic have several consecutive arrays, which
+  /// are concatenated for the test cases.
+  std::vector<unsigned> symbolicChunks;
+
   /// @brief Set of used array names for this state.  Used to avoid collisions.
   std::set<std::string> arrayNames;
 
@@ -288,7 +298,8 @@ public:
   void pushFrame(KInstIterator caller, KFunction *kf);
   void popFrame();
 
-  void addSymbolic(const MemoryObject *mo, const Array *array);
+  void addSymbolic(const MemoryObject *mo, const Array *array,
+                   unsigned chunk = 0);
   void addConstraint(ref<Expr> e) {
     constraints.addConstraint(e);
 
@@ -306,11 +317,11 @@ public:
     this->type = type;
   }
 
-  bool isNormalState() {
+  bool isNormalState() const {
     return (type & NORMAL_STATE) != 0;
   }
 
-  bool isRecoveryState() {
+  bool isRecoveryState() const {
     return (type & RECOVERY_STATE) != 0;
   }
 
@@ -431,7 +442,7 @@ public:
     originatingState = state;
   }
 
-  ref<RecoveryInfo> getRecoveryInfo() {
+  ref<RecoveryInfo> getRecoveryInfo() const {
     assert(isRecoveryState());
     return recoveryInfo;
   }
@@ -558,6 +569,18 @@ public:
     valuesCache[address] = expr;
   };
 
+  void clearRecoveredValue(
+    unsigned int index,
+    unsigned int sliceId,
+    uint64_t address
+  ) {
+    auto key = std::make_pair(index, sliceId);
+    RecoveryCache::iterator i = recoveryCache.find(key);
+    if (i != recoveryCache.end()) {
+      i->second.erase(address);
+    }
+  };
+
   bool getRecoveredValue(
     unsigned int index,
     unsigned int sliceId,
@@ -580,7 +603,20 @@ public:
     return true;
   };
 
-  unsigned int getLevel() {
+  ref<PendingAllocations> getPendingAllocations() {
+    return pendingAllocations;
+  }
+
+  unsigned int getPendingAllocationsIndex() {
+    return pendingAllocationsIndex;
+  }
+
+  void setPendingAllocations(ref<PendingAllocations> allocations, unsigned int index) {
+    pendingAllocations = allocations;
+    pendingAllocationsIndex = index;
+  }
+
+  unsigned int getLevel() const {
     assert(isRecoveryState());
     return level;
   }
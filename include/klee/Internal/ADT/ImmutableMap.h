@@ -96,6 +96,11 @@ namespace klee {
       return elts.upper_bound(key); 
     }
 
+    template<class Visitor>
+    void diff(const ImmutableMap &b, Visitor &v) const {
+      elts.diff(b.elts, v);
+    }
+
     static size_t getAllocated() { return Tree::allocated; }
   };
 
@@ -57,6 +57,16 @@ namespace klee {
     iterator lower_bound(const key_type &key) const;
     iterator upper_bound(const key_type &key) const;
 
+    // report the differences from this tree to b: v.added(value) for
+    // the values only in b, v.removed(value) for the values only in
+    // this tree, and v.changed(value, bValue) for the keys in both
+    // trees whose values are held by different nodes. the subtrees
+    // which are shared by the trees are skipped, so for trees which
+    // were derived from each other the cost is proportional to the
+    // number of changes (times the height), not to the size.
+    template<class Visitor>
+    void diff(const ImmutableTree &b, Visitor &v) const;
+
     static size_t getAllocated() { return allocated; }
 
   private:
@@ -615,6 +625,68 @@ namespace klee {
     return it;
   }
 
+  template<class K, class V, class KOV, class CMP>
+  template<class Visitor>
+  void ImmutableTree<K,V,KOV,CMP>::diff(const ImmutableTree &b,
+                                         Visitor &v) const {
+    // the parts of each tree which were not visited yet, in reverse
+    // order: either a whole subtree, or only the value of a node whose
+    // left subtree was already expanded
+    typedef std::pair<Node*, bool> Part;
+    std::vector<Part> as, bs;
+    as.push_back(Part(node, true));
+    bs.push_back(Part(b.node, true));
+
+    while (!as.empty() || !bs.empty()) {
+      if (!as.empty() && as.back().second && as.back().first->isTerminator()) {
+        as.pop_back();
+        continue;
+      }
+      if (!bs.empty() && bs.back().second && bs.back().first->isTerminator()) {
+        bs.pop_back();
+        continue;
+      }
+
+      // a shared subtree, or the value of a shared node
+      if (!as.empty() && !bs.empty() && as.back() == bs.back()) {
+        as.pop_back();
+        bs.pop_back();
+        continue;
+      }
+
+      // expand the taller subtree first, so that the shared subtrees
+      // meet at the same height
+      unsigned ah = (!as.empty() && as.back().second) ? as.back().first->height : 0;
+      unsigned bh = (!bs.empty() && bs.back().second) ? bs.back().first->height : 0;
+      if (ah || bh) {
+        std::vector<Part> &parts = (ah >= bh) ? as : bs;
+        Node *n = parts.back().first;
+        parts.pop_back();
+        parts.push_back(Part(n->right, true));
+        parts.push_back(Part(n, false));
+        parts.push_back(Part(n->left, true));
+        continue;
+      }
+
+      // both sides are single values (or exhausted)
+      if (bs.empty() ||
+          (!as.empty() && key_compare()(key_of_value()(as.back().first->value),
+                                        key_of_value()(bs.back().first->value)))) {
+        v.removed(as.back().first->value);
+        as.pop_back();
+      } else if (as.empty() ||
+                 key_compare()(key_of_value()(bs.back().first->value),
+                               key_of_value()(as.back().first->value))) {
+        v.added(bs.back().first->value);
+        bs.pop_back();
+      } else {
+        v.changed(as.back().first->value, bs.back().first->value);
+        as.pop_back();
+        bs.pop_back();
+      }
+    }
+  }
+
 }
 
 #endif
@@ -126,6 +126,11 @@ namespace klee {
     // Mark function with functionName as part of the KLEE runtime
     void addInternalFunction(const char* functionName);
 
+    /// Links the intrinsics and runs the module passes (everything which
+    /// is cached in a prepared module).
+    void transform(const Interpreter::ModuleOptions &opts,
+                   const std::vector<Interpreter::SkippedFunctionOption> &skippedFunctions);
+
   public:
     KModule(llvm::Module *_module);
     ~KModule();
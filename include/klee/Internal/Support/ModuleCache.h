@@ -0,0 +1,64 @@
+//===-- ModuleCache.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A content-addressed cache of prepared modules, i.e. modules linked with
+// the runtime libraries and transformed by KModule::prepare, up to (but not
+// including) the skipped functions analyses.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_MODULECACHE_H
+#define KLEE_MODULECACHE_H
+
+#include "llvm/Support/MD5.h"
+
+#include <string>
+
+namespace llvm {
+  class LLVMContext;
+  class Module;
+}
+
+namespace klee {
+
+  /// ModuleCacheKey - Hashes everything a prepared module depends on: the
+  /// contents of the input files, and the options which change the
+  /// linking or the transformations.
+  class ModuleCacheKey {
+    llvm::MD5 hash;
+
+  public:
+    /// Adds the contents of a file. Returns false if the file can not be
+    /// read.
+    bool addFile(const std::string &path);
+
+    void addString(const std::string &s);
+
+    /// Returns the path of the prepared module in the cache directory.
+    /// No more data can be added afterwards.
+    std::string getPath(const std::string &cacheDir);
+  };
+
+  /// Describes the options which change the transformations done by
+  /// KModule::prepare, for the key of a prepared module.
+  std::string getModuleTransformOptions();
+
+  /// Loads a prepared module from the cache. Returns null if it is not
+  /// cached or can not be read.
+  llvm::Module *loadCachedModule(const std::string &path,
+                                 llvm::LLVMContext &ctx);
+
+  /// Writes a prepared module to the cache. The module is written to a
+  /// temporary file first, so that concurrent runs never read a partial
+  /// module.
+  void storeCachedModule(llvm::Module *module, const std::string &path);
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+//===-- PhaseTrace.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Records the begin and end of the executor phases (solving, forking,
+// slicing, ...) in the Chrome trace-event format, which can be viewed in
+// chrome://tracing or Perfetto.
+//
+// A phase is recorded as a single complete event when it ends. The events
+// are recorded by the interpreter thread into a lock-free ring buffer,
+// which is written to the trace file by a separate thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PHASETRACE_H
+#define KLEE_PHASETRACE_H
+
+#include <string>
+
+namespace klee {
+namespace trace {
+  enum Phase {
+    Interpret,
+    Recovery,
+    Solver,
+    Fork,
+    Slicing,
+    TestGeneration,
+    Stats,
+    NumPhases
+  };
+
+  /// Whether the events are recorded (set by open()).
+  extern bool enabled;
+
+  /// Starts recording into the given file. Returns false if the file can
+  /// not be created.
+  bool open(const std::string &path);
+
+  /// Writes the remaining events and closes the trace file.
+  void close();
+
+  /// Records the begin of a phase. The state (if any) and its recovery
+  /// level are added as arguments of the event.
+  void begin(Phase phase, const void *state = 0, int level = -1);
+
+  /// Records the end of the innermost phase, which must be \a phase.
+  void end(Phase phase);
+
+  /// PhaseScope - Records a phase for the lifetime of the object.
+  class PhaseScope {
+    Phase phase;
+    bool active;
+
+  public:
+    PhaseScope(Phase _phase, const void *state = 0, int level = -1)
+        : phase(_phase), active(enabled) {
+      if (active)
+        begin(phase, state, level);
+    }
+    ~PhaseScope() {
+      if (active)
+        end(phase);
+    }
+  };
+}
+}
+
+#endif
@@ -15,6 +15,11 @@
 namespace klee {
   namespace util {
     size_t GetTotalMallocUsage();
+
+    /// Whether GetTotalMallocUsage() reads the counters of the allocator
+    /// (tcmalloc, jemalloc or ASan), instead of walking its free lists, so
+    /// that it is cheap enough to call whenever a state is created.
+    bool IsMallocUsageCheap();
   }
 }
 
@@ -0,0 +1,84 @@
+//===-- PerfCounters.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Hardware performance counters (through perf_event_open on Linux),
+// attributed to the executor phase which is active when they are read.
+// Only user-space events are counted, so that no privileges are needed when
+// perf_event_paranoid is at most 2.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_UTIL_PERFCOUNTERS_H
+#define KLEE_UTIL_PERFCOUNTERS_H
+
+#include <stdint.h>
+
+namespace klee {
+  namespace perf {
+    enum Phase {
+      Interpreter,
+      Solver,
+      Fork,
+      Recovery,
+      Searcher,
+      NumPhases
+    };
+
+    enum Counter {
+      Cycles,
+      Instructions,
+      LLCMisses,
+      BranchMisses,
+      NumCounters
+    };
+
+    /// Whether the counters are running (set by start()).
+    extern bool enabled;
+
+    /// Opens the counters, and attributes them to the interpreter phase.
+    /// Returns false if none of the counters is available.
+    bool start();
+
+    void stop();
+
+    /// Attributes the counts since the last transition to the current phase,
+    /// and makes \a phase the current one.
+    /// \return The previous phase.
+    Phase enter(Phase phase);
+
+    /// Returns the counts attributed to the given phase (up to the last
+    /// transition, see update()).
+    uint64_t getValue(Phase phase, Counter counter);
+
+    /// Attributes the counts since the last transition to the current phase.
+    void update();
+
+    const char *getPhaseName(Phase phase);
+    const char *getCounterName(Counter counter);
+
+    /// PhaseScope - Attributes the counts to a phase for the lifetime of the
+    /// object, and then back to the enclosing one.
+    class PhaseScope {
+      Phase previous;
+      bool active;
+
+    public:
+      PhaseScope(Phase phase) : active(enabled) {
+        if (active)
+          previous = enter(phase);
+      }
+      ~PhaseScope() {
+        if (active)
+          enter(previous);
+      }
+    };
+  }
+}
+
+#endif
@@ -61,12 +61,19 @@ public:
     bool Optimize;
     bool CheckDivZero;
     bool CheckOvershift;
+    /// The module was loaded from the prepared module cache, so it is
+    /// already linked and transformed.
+    bool Prepared;
+    /// Where to store the module once it is transformed (empty if it is not
+    /// cached).
+    std::string PreparedModuleCache;
 
     ModuleOptions(const std::string &_LibraryDir,
                   const std::string &_EntryPoint, bool _Optimize,
                   bool _CheckDivZero, bool _CheckOvershift)
         : LibraryDir(_LibraryDir), EntryPoint(_EntryPoint), Optimize(_Optimize),
-          CheckDivZero(_CheckDivZero), CheckOvershift(_CheckOvershift) {}
+          CheckDivZero(_CheckDivZero), CheckOvershift(_CheckOvershift),
+          Prepared(false) {}
   };
 
   enum LogType
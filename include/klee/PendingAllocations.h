@@ -0,0 +1,55 @@
+#ifndef KLEE_PENDING_ALLOCATIONS_H
+#define KLEE_PENDING_ALLOCATIONS_H
+
+#include <vector>
+
+namespace klee {
+
+class MemoryObject;
+
+/* an append-only log of the allocations (and deallocations) executed by
+   recovery states, which is shared by the states of a dependent chain.
+   each dependent state binds the logged objects only when it resumes. */
+class PendingAllocations {
+public:
+
+    struct Entry {
+        const MemoryObject *mo;
+        bool isLocal;
+        bool zeroMemory;
+        bool isFree;
+    };
+
+    PendingAllocations() : refCount(0) {
+
+    }
+
+    PendingAllocations(const PendingAllocations &other);
+
+    ~PendingAllocations();
+
+    void addAlloc(const MemoryObject *mo, bool isLocal, bool zeroMemory);
+
+    void addFree(const MemoryObject *mo);
+
+    unsigned int size() const {
+        return entries.size();
+    }
+
+    const Entry &getEntry(unsigned int index) const {
+        return entries[index];
+    }
+
+    unsigned int refCount;
+
+private:
+    PendingAllocations &operator=(const PendingAllocations &other);
+
+    void add(const MemoryObject *mo, bool isLocal, bool zeroMemory, bool isFree);
+
+    std::vector<Entry> entries;
+};
+
+}
+
+#endif
@@ -243,6 +243,29 @@ namespace klee {
   };
 #endif // ENABLE_Z3
 
+  /// SMTLIBSolver - A complete solver which sends the queries in the
+  /// SMT-LIBv2 format to a pool of external solver processes. The
+  /// processes are reused incrementally (with push and pop) by the queries
+  /// which share a prefix of their constraints.
+  class SMTLIBSolver : public Solver {
+  public:
+    /// SMTLIBSolver - Construct a new SMTLIBSolver.
+    ///
+    /// \param command - The shell command which starts the solver, which
+    /// reads the commands from its standard input.
+    /// \param poolSize - The maximal number of solver processes.
+    SMTLIBSolver(const std::string &command, unsigned poolSize);
+
+    /// Get the query in SMT-LIBv2 format.
+    /// \return A C-style string. The caller is responsible for freeing this.
+    virtual char *getConstraintLog(const Query &);
+
+    /// setCoreSolverTimeout - Set constraint solver timeout delay to the given
+    /// value; 0
+    /// is off.
+    virtual void setCoreSolverTimeout(double timeout);
+  };
+
 #ifdef ENABLE_METASMT
   
   template<typename SolverContext>
@@ -26,6 +26,7 @@ namespace stats {
   extern Statistic queryConstructTime;
   extern Statistic queryConstructs;
   extern Statistic queryCounterexamples;
+  extern Statistic queryLookupTables;
   extern Statistic queryTime;
   
 #ifdef DEBUG
@@ -31,12 +31,19 @@ namespace klee {
 
   private:
     unsigned id;
+    /// The position of the statistic in the per-instruction records, or -1
+    /// if the statistic is not kept per instruction.
+    int indexedId;
     const std::string name;
     const std::string shortName;
+    const bool indexed;
 
   public:
+    /// \param _indexed - Whether the statistic is also kept per instruction
+    /// (see StatisticManager::useIndexedStats).
     Statistic(const std::string &_name, 
-              const std::string &_shortName);
+              const std::string &_shortName,
+              bool _indexed = false);
     ~Statistic();
 
     /// getID - Get the unique statistic ID.
@@ -49,6 +56,9 @@ namespace klee {
     /// callgrind output for example.
     const std::string &getShortName() const { return shortName; }
 
+    /// isIndexed - Whether the statistic is kept per instruction.
+    bool isIndexed() const { return indexed; }
+
     /// getValue - Get the current primary statistic value.
     uint64_t getValue() const;
 
@@ -12,6 +12,8 @@
 
 #include "Statistic.h"
 
+#include <atomic>
+#include <cassert>
 #include <vector>
 #include <string>
 #include <string.h>
@@ -37,14 +39,49 @@ namespace klee {
     StatisticRecord &operator +=(const StatisticRecord &sr);
   };
 
+  /// StatisticBlock - The counters of a single thread.
+  ///
+  /// Each thread only updates its own block, so that incrementing a
+  /// statistic needs neither a lock nor an atomic read-modify-write, and
+  /// the blocks of different threads never share a cache line. The value
+  /// of a statistic is the sum over all the blocks.
+  struct alignas(64) StatisticBlock {
+    enum { MaxStatistics = 64 };
+
+    std::atomic<uint64_t> values[MaxStatistics];
+    StatisticBlock *next;
+
+    /// The instruction and the call path context which the thread
+    /// attributes its statistics to (see StatisticManager::setIndex).
+    unsigned index;
+    StatisticRecord *context;
+    bool indexing;
+
+    void add(unsigned id, uint64_t addend) {
+      values[id].store(values[id].load(std::memory_order_relaxed) + addend,
+                       std::memory_order_relaxed);
+    }
+  };
+
+  /// The block of the current thread, created on its first use.
+  extern thread_local StatisticBlock *currentStatisticBlock;
+
   class StatisticManager {
   private:
     bool enabled;
     std::vector<Statistic*> stats;
-    uint64_t *globalStats;
+    /// The number of statistics which are kept per instruction.
+    unsigned numIndexed;
+    /// The blocks of all the threads which have used a statistic. Blocks
+    /// are only added (with a compare-and-swap) and never freed, so that
+    /// the counts of threads which have exited are kept.
+    std::atomic<StatisticBlock*> blocks;
+    /// The per-instruction statistics, numIndexed entries per instruction.
+    /// Only updated by the threads which set an index.
     uint64_t *indexedStats;
-    StatisticRecord *contextStats;
-    unsigned index;
+
+    StatisticBlock *getBlock();
+    StatisticBlock *createBlock();
 
   public:
     StatisticManager();
@@ -52,11 +89,12 @@ namespace klee {
 
     void useIndexedStats(unsigned totalIndices);
 
+    /// The context and the index apply to the calling thread.
     StatisticRecord *getContext();
     void setContext(StatisticRecord *sr); /* null to reset */
 
-    void setIndex(unsigned i) { index = i; }
-    unsigned getIndex() { return index; }
+    void setIndex(unsigned i);
+    unsigned getIndex() { return getBlock()->index; }
     unsigned getNumStatistics() { return stats.size(); }
     Statistic &getStatistic(unsigned i) { return *stats[i]; }
     
@@ -73,23 +111,36 @@ namespace klee {
 
   extern StatisticManager *theStatisticManager;
 
+  inline StatisticBlock *StatisticManager::getBlock() {
+    StatisticBlock *b = currentStatisticBlock;
+    return b ? b : createBlock();
+  }
+
   inline void StatisticManager::incrementStatistic(Statistic &s, 
                                                    uint64_t addend) {
     if (enabled) {
-      globalStats[s.id] += addend;
-      if (indexedStats) {
-        indexedStats[index*stats.size() + s.id] += addend;
-        if (contextStats)
-          contextStats->data[s.id] += addend;
+      StatisticBlock *b = getBlock();
+      b->add(s.id, addend);
+      if (indexedStats && b->indexing) {
+        if (s.indexedId >= 0)
+          indexedStats[b->index*numIndexed + s.indexedId] += addend;
+        if (b->context)
+          b->context->data[s.id] += addend;
       }
     }
   }
 
+  inline void StatisticManager::setIndex(unsigned i) {
+    StatisticBlock *b = getBlock();
+    b->index = i;
+    b->indexing = true;
+  }
+
   inline StatisticRecord *StatisticManager::getContext() {
-    return contextStats;
+    return getBlock()->context;
   }
   inline void StatisticManager::setContext(StatisticRecord *sr) {
-    contextStats = sr;
+    getBlock()->context = sr;
   }
 
   inline void StatisticRecord::zero() {
@@ -129,25 +180,25 @@ namespace klee {
     return *this;
   }
 
-  inline uint64_t StatisticManager::getValue(const Statistic &s) const {
-    return globalStats[s.id];
-  }
 
   inline void StatisticManager::incrementIndexedValue(const Statistic &s, 
                                                       unsigned index,
                                                       uint64_t addend) const {
-    indexedStats[index*stats.size() + s.id] += addend;
+    assert(s.indexedId >= 0 && "statistic is not indexed");
+    indexedStats[index*numIndexed + s.indexedId] += addend;
   }
 
   inline uint64_t StatisticManager::getIndexedValue(const Statistic &s, 
                                                     unsigned index) const {
-    return indexedStats[index*stats.size() + s.id];
+    assert(s.indexedId >= 0 && "statistic is not indexed");
+    return indexedStats[index*numIndexed + s.indexedId];
   }
 
   inline void StatisticManager::setIndexedValue(const Statistic &s, 
                                                 unsigned index,
                                                 uint64_t value) {
-    indexedStats[index*stats.size() + s.id] = value;
+    assert(s.indexedId >= 0 && "statistic is not indexed");
+    indexedStats[index*numIndexed + s.indexedId] = value;
   }
 }
 
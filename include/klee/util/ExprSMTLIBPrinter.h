@@ -209,6 +209,23 @@ public:
   /// \return True if human readable mode is switched on
   bool isHumanReadable();
 
+  /// Prepare the printing of a single expression, which is used by solvers
+  /// that send the constraints one at a time (see printAssertion()).
+  /// This does not require setQuery().
+  void setExpression(const ref<Expr> &e);
+
+  /// The arrays found by the last call to setQuery() or setExpression()
+  const std::set<const Array *> &getUsedArrays() const { return usedArrays; }
+
+  /// Print the declaration of the given array, followed by the assertions of
+  /// its values if it is a constant array. setOutput() must be called before
+  /// calling this.
+  void printArrayDeclaration(const Array *array);
+
+  /// Print an (assert ...) command for the expression which was passed to
+  /// setExpression(). setOutput() must be called before calling this.
+  void printAssertion(const ref<Expr> &e);
+
 protected:
   /// Contains the arrays found during scans
   std::set<const Array *> usedArrays;
@@ -258,6 +275,12 @@ protected:
   // Print SMTLIBv2 assertions for constant arrays
   void printArrayDeclarations();
 
+  // Print the (declare-fun ...) command of an array
+  void printArrayDeclarationOnly(const Array *array);
+
+  // Print the assertions of the values of a constant array
+  void printConstantArrayValues(const Array *array);
+
   // Print SMTLIBv2 for the query optimised for human readability
   void printHumanReadableQuery();
 
@@ -0,0 +1,143 @@
+//===-- ExprSerializer.h ----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_EXPRSERIALIZER_H
+#define KLEE_EXPRSERIALIZER_H
+
+#include "klee/Expr.h"
+#include "klee/util/ExprHashMap.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class APInt;
+  class raw_ostream;
+}
+
+namespace klee {
+  class ArrayCache;
+  class ExprBuilder;
+
+  /// The binary format of ExprSerializer.
+  ///
+  /// A stream starts with the magic "KQB", followed by the version byte,
+  /// and is a sequence of records. Each record starts with a tag byte and
+  /// defines an array, an update node, an expression or a query. Arrays,
+  /// update nodes and expressions are numbered in the order of their
+  /// records (one sequence for each), and a record refers only to the
+  /// numbers of previous records, so that every shared node is written
+  /// once per stream. The numbers are unsigned LEB128 varints, and the
+  /// strings are a length followed by the bytes.
+  ///
+  ///   array:  name, size, domain, range, constant?, [values]
+  ///   update: next + 1 (0 for the end of the list), index, value
+  ///   expr:   kind, operands (constants: width, words; extract: expr,
+  ///           offset, width; casts: expr, width; reads: array,
+  ///           update + 1, index; the others: their kids)
+  ///   query:  #constraints, constraints, query, #values, values,
+  ///           #objects, objects
+  namespace serialization {
+    const char Magic[] = { 'K', 'Q', 'B' };
+    const unsigned char Version = 1;
+
+    enum RecordTag {
+      ArrayRecord = 1,
+      UpdateRecord,
+      ExprRecord,
+      QueryRecord
+    };
+
+    /// Whether the buffer holds a serialized stream.
+    bool isSerialized(const char *begin, const char *end);
+  }
+
+  /// ExprSerializer - Writes expressions, arrays and queries to a binary
+  /// stream which preserves their sharing. The nodes which were already
+  /// written are remembered, so a stream of queries with common subterms
+  /// (e.g. a query log) writes each subterm once.
+  class ExprSerializer {
+    llvm::raw_ostream &os;
+
+    std::map<const Array*, unsigned> arrays;
+    std::map<const UpdateNode*, unsigned> updates;
+    ExprHashMap<unsigned> exprs;
+    /// Holds the written update nodes, which are numbered by address.
+    std::vector<UpdateList> keptUpdates;
+
+    void writeVarint(uint64_t value);
+    void writeString(const std::string &s);
+    void writeConstant(const ConstantExpr *ce);
+    unsigned writeUpdate(const UpdateNode *un);
+
+  public:
+    /// Writes the header of the stream.
+    ExprSerializer(llvm::raw_ostream &_os);
+
+    /// Write the records of an expression (and of its subterms) which
+    /// were not written yet, and return its number.
+    unsigned write(const ref<Expr> &e);
+    unsigned write(const Array *array);
+
+    void writeQuery(const std::vector< ref<Expr> > &constraints,
+                    const ref<Expr> &query,
+                    const std::vector< ref<Expr> > &values,
+                    const std::vector<const Array*> &objects);
+  };
+
+  /// ExprDeserializer - Reads a stream written by ExprSerializer. The
+  /// expressions are created by the given builder (the default builder
+  /// reproduces them exactly), and the arrays by the given cache.
+  class ExprDeserializer {
+    const unsigned char *pos, *end;
+    ExprBuilder *builder;
+    ArrayCache *arrayCache;
+    std::string error;
+
+    std::vector<const Array*> arrays;
+    std::vector<UpdateList> updates;
+    std::vector< ref<Expr> > exprs;
+
+    bool fail(const std::string &message);
+    bool readByte(unsigned char &value);
+    bool readVarint(uint64_t &value);
+    bool readString(std::string &s);
+    bool readConstant(llvm::APInt &value);
+    bool readExprRef(ref<Expr> &e);
+    bool readArrayRef(const Array *&array);
+    bool readArray();
+    bool readUpdate();
+    bool readExpr();
+    bool readExprList(std::vector< ref<Expr> > &result);
+
+  public:
+    ExprDeserializer(const char *begin, const char *end,
+                     ExprBuilder *_builder, ArrayCache *_arrayCache);
+
+    /// Read the records up to the next query. Returns false at the end
+    /// of the stream, or on an error (see getError()).
+    bool readQuery(std::vector< ref<Expr> > &constraints, ref<Expr> &query,
+                   std::vector< ref<Expr> > &values,
+                   std::vector<const Array*> &objects);
+
+    /// Read the remaining records (e.g. of a stream of expressions).
+    bool readAll();
+
+    unsigned getNumExprs() const { return exprs.size(); }
+    ref<Expr> getExpr(unsigned id) const { return exprs[id]; }
+    unsigned getNumArrays() const { return arrays.size(); }
+    const Array *getArray(unsigned id) const { return arrays[id]; }
+
+    /// The description of the error, or empty.
+    const std::string &getError() const { return error; }
+  };
+}
+
+#endif
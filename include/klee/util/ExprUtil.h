@@ -10,10 +10,12 @@
 #ifndef KLEE_EXPRUTIL_H
 #define KLEE_EXPRUTIL_H
 
+#include <utility>
 #include <vector>
 
 namespace klee {
   class Array;
+  class ConstantExpr;
   class Expr;
   class ReadExpr;
   template<typename T> class ref;
@@ -38,6 +40,24 @@ namespace klee {
                            InputIterator end,
                            std::vector<const Array*> &results);
 
+  /// Return true if the expression DAG has more than maxNodes distinct
+  /// nodes or is deeper than maxDepth, where the updates of the arrays read
+  /// by the expression count as nodes and as depth (0 disables a limit).
+  /// The traversal stops as soon as a limit is exceeded, so its cost is
+  /// bounded by the limits.
+  bool exceedsComplexity(ref<Expr> e, unsigned maxNodes, unsigned maxDepth);
+
+  /// The runs of equal values of a constant array, as the first index of
+  /// each run with its value.
+  typedef std::vector< std::pair<unsigned, ref<ConstantExpr> > >
+    ConstantArrayRuns;
+
+  /// Partition the values of a constant array into runs of equal values,
+  /// so that the solver builders can encode the reads of a lookup table
+  /// without an array. Return false if there are more than maxRuns runs.
+  bool getConstantArrayRuns(const Array *array, unsigned maxRuns,
+                            ConstantArrayRuns &runs);
+
 }
 
 #endif
@@ -64,6 +64,11 @@ CoreSolverOptimizeDivides("solver-optimize-divides",
                  llvm::cl::desc("Optimize constant divides into add/shift/multiplies before passing to core SMT solver (default=off)"),
                  llvm::cl::init(false));
 
+llvm::cl::opt<unsigned>
+LookupTableMaxRuns("lookup-table-max-runs",
+                   llvm::cl::desc("Encode the reads of a constant array at a symbolic index as a tree of if-then-else over its runs of equal values, if it has at most this many runs, instead of as an array (default=256, 0=off)"),
+                   llvm::cl::init(256));
+
 
 /* Using cl::list<> instead of cl::bits<> results in quite a bit of ugliness when it comes to checking
  * if an option is set. Unfortunately with gcc4.7 cl::bits<> is broken with LLVM2.9 and I doubt everyone
@@ -137,6 +142,8 @@ llvm::cl::opt<CoreSolverType> CoreSolverToUse(
                      clEnumValN(METASMT_SOLVER, "metasmt", "metaSMT" METASMT_IS_DEFAULT_STR),
                      clEnumValN(DUMMY_SOLVER, "dummy", "Dummy solver"),
                      clEnumValN(Z3_SOLVER, "z3", "Z3" Z3_IS_DEFAULT_STR),
+                     clEnumValN(SMTLIB_SOLVER, "smtlib",
+                                "An external SMT-LIBv2 solver (see -smtlib-solver-command)"),
                      clEnumValEnd),
     llvm::cl::init(DEFAULT_CORE_SOLVER));
 
@@ -148,10 +155,23 @@ llvm::cl::opt<CoreSolverType> DebugCrossCheckCoreSolverWith(
                      clEnumValN(METASMT_SOLVER, "metasmt", "metaSMT"),
                      clEnumValN(DUMMY_SOLVER, "dummy", "Dummy solver"),
                      clEnumValN(Z3_SOLVER, "z3", "Z3"),
+                     clEnumValN(SMTLIB_SOLVER, "smtlib", "External SMT-LIBv2 solver"),
                      clEnumValN(NO_SOLVER, "none",
                                 "Do not cross check (default)"),
                      clEnumValEnd),
     llvm::cl::init(NO_SOLVER));
+
+llvm::cl::opt<std::string> SMTLIBSolverCommand(
+    "smtlib-solver-command",
+    llvm::cl::desc("The command which starts a solver reading SMT-LIBv2 from "
+                   "its standard input (default=\"z3 -in\")"),
+    llvm::cl::init("z3 -in"));
+
+llvm::cl::opt<unsigned> SMTLIBSolverPoolSize(
+    "smtlib-solver-pool-size",
+    llvm::cl::desc("The maximal number of running SMT-LIBv2 solver processes "
+                   "(default=2)"),
+    llvm::cl::init(2));
 }
 #undef STP_IS_DEFAULT_STR
 #undef METASMT_IS_DEFAULT_STR
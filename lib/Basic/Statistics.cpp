@@ -9,35 +9,65 @@
 
 #include "klee/Statistics.h"
 
+#include <new>
+#include <stdlib.h>
 #include <vector>
 
 using namespace klee;
 
+thread_local StatisticBlock *klee::currentStatisticBlock = 0;
+
 StatisticManager::StatisticManager()
   : enabled(true),
-    globalStats(0),
-    indexedStats(0),
-    contextStats(0),
-    index(0) {
+    numIndexed(0),
+    blocks(0),
+    indexedStats(0) {
 }
 
 StatisticManager::~StatisticManager() {
-  if (globalStats) delete[] globalStats;
   if (indexedStats) delete[] indexedStats;
 }
 
+StatisticBlock *StatisticManager::createBlock() {
+  void *mem;
+  if (posix_memalign(&mem, alignof(StatisticBlock), sizeof(StatisticBlock)))
+    abort();
+
+  StatisticBlock *b = new (mem) StatisticBlock();
+  for (unsigned i=0; i<StatisticBlock::MaxStatistics; i++)
+    b->values[i].store(0, std::memory_order_relaxed);
+  b->index = 0;
+  b->context = 0;
+  b->indexing = false;
+
+  b->next = blocks.load(std::memory_order_relaxed);
+  while (!blocks.compare_exchange_weak(b->next, b, std::memory_order_release,
+                                       std::memory_order_relaxed))
+    ;
+  currentStatisticBlock = b;
+  return b;
+}
+
+uint64_t StatisticManager::getValue(const Statistic &s) const {
+  uint64_t value = 0;
+  for (StatisticBlock *b = blocks.load(std::memory_order_acquire); b;
+       b = b->next)
+    value += b->values[s.id].load(std::memory_order_relaxed);
+  return value;
+}
+
 void StatisticManager::useIndexedStats(unsigned totalIndices) {  
   if (indexedStats) delete[] indexedStats;
-  indexedStats = new uint64_t[totalIndices * stats.size()];
-  memset(indexedStats, 0, sizeof(*indexedStats) * totalIndices * stats.size());
+  indexedStats = new uint64_t[totalIndices * numIndexed];
+  memset(indexedStats, 0, sizeof(*indexedStats) * totalIndices * numIndexed);
 }
 
 void StatisticManager::registerStatistic(Statistic &s) {
-  if (globalStats) delete[] globalStats;
+  assert(stats.size() < StatisticBlock::MaxStatistics &&
+         "too many statistics");
   s.id = stats.size();
+  s.indexedId = s.indexed ? (int) numIndexed++ : -1;
   stats.push_back(&s);
-  globalStats = new uint64_t[stats.size()];
-  memset(globalStats, 0, sizeof(*globalStats)*stats.size());
 }
 
 int StatisticManager::getStatisticID(const std::string &name) const {
@@ -65,9 +95,11 @@ static StatisticManager &getStatisticManager() {
 /* *** */
 
 Statistic::Statistic(const std::string &_name, 
-                     const std::string &_shortName) 
+                     const std::string &_shortName,
+                     bool _indexed) 
   : name(_name), 
-    shortName(_shortName) {
+    shortName(_shortName),
+    indexed(_indexed) {
   getStatisticManager().registerStatistic(*this);
 }
 
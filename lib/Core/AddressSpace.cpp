@@ -15,6 +15,8 @@
 #include "klee/Expr.h"
 #include "klee/TimerStatIncrementer.h"
 
+#include <algorithm>
+
 using namespace klee;
 
 ///
@@ -35,6 +37,87 @@ const ObjectState *AddressSpace::findObject(const MemoryObject *mo) const {
   return res ? res->second : 0;
 }
 
+namespace {
+  /// Collects the deltas reported by MemoryMap::diff.
+  struct DeltaCollector {
+    ObjectDeltas &deltas;
+
+    DeltaCollector(ObjectDeltas &_deltas) : deltas(_deltas) {}
+
+    void added(const MemoryMap::value_type &v) {
+      deltas.push_back(ObjectDelta(v.first, 0, v.second));
+    }
+    void removed(const MemoryMap::value_type &v) {
+      deltas.push_back(ObjectDelta(v.first, v.second, 0));
+    }
+    void changed(const MemoryMap::value_type &a, const MemoryMap::value_type &b) {
+      /* the node was copied, e.g. by a rebalance, but not the object */
+      if ((const ObjectState*) a.second == (const ObjectState*) b.second)
+        return;
+      deltas.push_back(ObjectDelta(a.first, a.second, b.second));
+    }
+  };
+}
+
+void AddressSpace::diff(const AddressSpace &b, ObjectDeltas &deltas) const {
+  DeltaCollector collector(deltas);
+  objects.diff(b.objects, collector);
+}
+
+uint64_t AddressSpace::applyDiff(const ObjectDeltas &deltas, uint64_t address,
+                                 uint64_t size) {
+  uint64_t rangeEnd = (size > ~(uint64_t) 0 - address) ? ~(uint64_t) 0
+                                                      : address + size;
+  uint64_t changed = 0;
+
+  for (ObjectDeltas::const_iterator it = deltas.begin(), ie = deltas.end();
+       it != ie; ++it) {
+    const MemoryObject *mo = it->mo;
+    uint64_t start = std::max(mo->address, address);
+    uint64_t end = std::min(mo->address + mo->size, rangeEnd);
+    bool whole = address <= mo->address && mo->address + mo->size <= rangeEnd;
+    if (!whole && start >= end)
+      continue;
+
+    if (!it->to) {
+      if (whole)
+        unbindObject(mo);
+      continue;
+    }
+
+    const ObjectState *os = findObject(mo);
+    if (!os) {
+      if (it->to->readOnly) {
+        /* never written, so it can be shared */
+        objects = objects.replace(std::make_pair(mo,
+                                                 const_cast<ObjectState*>(it->to)));
+      } else {
+        bindObject(mo, new ObjectState(*it->to));
+      }
+      changed += end - start;
+      continue;
+    }
+
+    /* only the bytes written since the other side of the delta, the others
+       may have been written here in the meantime */
+    ObjectState *wos = 0;
+    for (uint64_t i = start - mo->address; i < end - mo->address; i++) {
+      ref<Expr> value = it->to->read8(i);
+      if (it->from && it->from->read8(i) == value)
+        continue;
+
+      changed++;
+      if (os->read8(i) == value)
+        continue;
+      if (!wos)
+        wos = getWriteable(mo, os);
+      wos->write(i, value);
+    }
+  }
+
+  return changed;
+}
+
 ObjectState *AddressSpace::getWriteable(const MemoryObject *mo,
                                         const ObjectState *os) {
   assert(!os->readOnly);
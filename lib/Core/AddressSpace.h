@@ -32,6 +32,20 @@ namespace klee {
   };
   
   typedef ImmutableMap<const MemoryObject*, ObjectHolder, MemoryObjectLT> MemoryMap;
+
+  /// The change of the binding of a MemoryObject between two address
+  /// spaces. \a from is null if the object is bound only in the second
+  /// address space, and \a to is null if it was unbound.
+  struct ObjectDelta {
+    const MemoryObject *mo;
+    const ObjectState *from;
+    const ObjectState *to;
+
+    ObjectDelta(const MemoryObject *_mo, const ObjectState *_from,
+                const ObjectState *_to) : mo(_mo), from(_from), to(_to) {}
+  };
+
+  typedef std::vector<ObjectDelta> ObjectDeltas;
   
   class AddressSpace {
   private:
@@ -100,6 +114,24 @@ namespace klee {
     /// Lookup a binding from a MemoryObject.
     const ObjectState *findObject(const MemoryObject *mo) const;
 
+    /// Compute the bindings which differ from this address space to \a
+    /// b. The object maps of address spaces which share history (e.g. a
+    /// state and its snapshot) share most of their nodes, so the time is
+    /// proportional to the number of changes rather than to the number
+    /// of objects.
+    void diff(const AddressSpace &b, ObjectDeltas &deltas) const;
+
+    /// Transfer a set of deltas (computed against another address space)
+    /// to this address space: the unbound objects are unbound, and the
+    /// bytes of the changed objects which are in the range [\a address,
+    /// \a address + \a size) and differ between the two sides of the
+    /// delta are copied, so the other bytes keep their values here. The
+    /// objects which are not bound in this address space yet are copied
+    /// entirely. Returns the number of bytes in the range which were
+    /// changed by the deltas.
+    uint64_t applyDiff(const ObjectDeltas &deltas, uint64_t address = 0,
+                       uint64_t size = ~(uint64_t) 0);
+
     /// \brief Obtain an ObjectState suitable for writing.
     ///
     /// This returns a writeable object state, creating a new copy of
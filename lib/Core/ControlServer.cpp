@@ -0,0 +1,231 @@
+//===-- ControlServer.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ControlServer.h"
+
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#include "llvm/Support/Errno.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <vector>
+
+using namespace klee;
+
+#ifdef MSG_NOSIGNAL
+static const int sendFlags = MSG_NOSIGNAL;
+#else
+static const int sendFlags = 0;
+#endif
+
+/* how often (in milliseconds) the listener checks whether it was stopped */
+static const int kPollInterval = 100;
+
+/* how long (in milliseconds) a client may take to send its whole command */
+static const int kReadTimeout = 1000;
+
+static const size_t kMaxCommandSize = 4096;
+
+ControlServer::ControlServer(const std::string &_path)
+    : path(_path), listenFd(-1), stopped(false), pending(false) {}
+
+ControlServer::~ControlServer() {
+  stopped = true;
+  if (listener.joinable())
+    listener.join();
+
+  if (listenFd != -1) {
+    ::close(listenFd);
+    ::unlink(path.c_str());
+  }
+
+  /* the requests which were not answered */
+  for (std::deque<Request>::iterator it = requests.begin();
+       it != requests.end(); ++it)
+    ::close(it->fd);
+}
+
+bool ControlServer::start() {
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    klee_warning("control socket path is too long: %s", path.c_str());
+    return false;
+  }
+  strcpy(addr.sun_path, path.c_str());
+
+  listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    klee_warning("unable to create the control socket - %s",
+                 llvm::sys::StrError(errno).c_str());
+    return false;
+  }
+
+  ::unlink(path.c_str());
+  if (::bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      ::listen(listenFd, 8) < 0) {
+    klee_warning("unable to bind the control socket %s - %s", path.c_str(),
+                 llvm::sys::StrError(errno).c_str());
+    ::close(listenFd);
+    listenFd = -1;
+    return false;
+  }
+
+  /* the executor timers must be delivered to the interpreter thread */
+  sigset_t blocked, old;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGALRM);
+  sigaddset(&blocked, SIGINT);
+  pthread_sigmask(SIG_BLOCK, &blocked, &old);
+  listener = std::thread(&ControlServer::listen, this);
+  pthread_sigmask(SIG_SETMASK, &old, 0);
+
+  klee_message("control socket: %s", path.c_str());
+  return true;
+}
+
+void ControlServer::listen() {
+  /* the connections are read without blocking, so that a client which does
+     not send its command does not delay the others (or the shutdown) */
+  std::vector<Connection> connections;
+  std::vector<struct pollfd> pfds;
+
+  while (!stopped) {
+    pfds.clear();
+    struct pollfd listenPfd = { listenFd, POLLIN, 0 };
+    pfds.push_back(listenPfd);
+    for (std::vector<Connection>::iterator it = connections.begin(),
+                                           ie = connections.end();
+         it != ie; ++it) {
+      struct pollfd pfd = { it->fd, POLLIN, 0 };
+      pfds.push_back(pfd);
+    }
+
+    int res = ::poll(&pfds[0], pfds.size(), kPollInterval);
+    if (res < 0 && errno != EINTR)
+      break;
+
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    std::vector<Connection> remaining;
+    for (unsigned i = 0; i < connections.size(); ++i) {
+      Connection &connection = connections[i];
+      ReadStatus status = ReadIncomplete;
+      if (res > 0 && pfds[i + 1].revents)
+        status = readCommand(connection);
+      if (status == ReadIncomplete && now >= connection.deadline)
+        status = ReadFailed;
+
+      if (status == ReadIncomplete) {
+        remaining.push_back(connection);
+      } else if (status == ReadFailed) {
+        ::close(connection.fd);
+      } else {
+        /* the response is sent by the interpreter thread, blocking */
+        int flags = ::fcntl(connection.fd, F_GETFL);
+        ::fcntl(connection.fd, F_SETFL, flags & ~O_NONBLOCK);
+
+        Request request;
+        request.fd = connection.fd;
+        request.command = connection.command;
+        std::lock_guard<std::mutex> guard(lock);
+        requests.push_back(request);
+        pending = true;
+      }
+    }
+    connections.swap(remaining);
+
+    if (res <= 0 || !(pfds[0].revents & POLLIN))
+      continue;
+
+    int fd = ::accept(listenFd, 0, 0);
+    if (fd < 0)
+      continue;
+
+    int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+      ::close(fd);
+      continue;
+    }
+
+    Connection connection;
+    connection.fd = fd;
+    connection.deadline = now + std::chrono::milliseconds(kReadTimeout);
+    connections.push_back(connection);
+  }
+
+  for (std::vector<Connection>::iterator it = connections.begin(),
+                                         ie = connections.end();
+       it != ie; ++it)
+    ::close(it->fd);
+}
+
+/// Reads what the client has sent so far. The command is a single line,
+/// without the line terminator.
+ControlServer::ReadStatus ControlServer::readCommand(Connection &connection) {
+  char buffer[256];
+  while (true) {
+    ssize_t n = ::read(connection.fd, buffer, sizeof(buffer));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return ReadIncomplete;
+      return ReadFailed;
+    }
+    if (n == 0)
+      return connection.command.empty() ? ReadFailed : ReadComplete;
+
+    for (ssize_t i = 0; i < n; ++i) {
+      if (buffer[i] == '\n')
+        return ReadComplete;
+      if (buffer[i] != '\r')
+        connection.command += buffer[i];
+    }
+    if (connection.command.size() >= kMaxCommandSize)
+      return ReadFailed;
+  }
+}
+
+bool ControlServer::popRequest(Request &request) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (requests.empty())
+    return false;
+
+  request = requests.front();
+  requests.pop_front();
+  pending = !requests.empty();
+  return true;
+}
+
+void ControlServer::reply(const Request &request, const std::string &response) {
+  std::string data = response + "\n";
+  const char *pos = data.data();
+  size_t size = data.size();
+  while (size) {
+    ssize_t n = ::send(request.fd, pos, size, sendFlags);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    pos += n;
+    size -= n;
+  }
+  ::close(request.fd);
+}
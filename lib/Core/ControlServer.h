@@ -0,0 +1,75 @@
+//===-- ControlServer.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_CONTROLSERVER_H
+#define KLEE_CONTROLSERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace klee {
+  /// ControlServer - Listens on a Unix domain socket for control commands
+  /// (one line per connection). The connections are accepted and read by a
+  /// separate thread, which only queues the commands: they are answered by
+  /// the interpreter thread (see Executor::processControlRequests()), so
+  /// that the executor is never accessed concurrently.
+  class ControlServer {
+  public:
+    struct Request {
+      /// The connection on which the response should be sent.
+      int fd;
+      std::string command;
+    };
+
+  private:
+    std::string path;
+    int listenFd;
+    std::thread listener;
+    std::atomic<bool> stopped;
+
+    std::mutex lock;
+    std::deque<Request> requests;
+    /// Whether the queue is not empty, checked without taking the lock.
+    std::atomic<bool> pending;
+
+    /// A connection whose command has not been read completely yet.
+    struct Connection {
+      int fd;
+      std::string command;
+      /// When the connection is dropped if the command is still incomplete.
+      std::chrono::steady_clock::time_point deadline;
+    };
+
+    enum ReadStatus { ReadIncomplete, ReadComplete, ReadFailed };
+
+    void listen();
+    ReadStatus readCommand(Connection &connection);
+
+  public:
+    ControlServer(const std::string &path);
+    ~ControlServer();
+
+    /// Creates the socket and starts the listening thread.
+    bool start();
+
+    bool hasRequests() const { return pending.load(std::memory_order_relaxed); }
+
+    /// Removes the oldest request from the queue.
+    bool popRequest(Request &request);
+
+    /// Sends the response of a request and closes its connection.
+    static void reply(const Request &request, const std::string &response);
+  };
+}
+
+#endif
@@ -12,18 +12,18 @@
 using namespace klee;
 
 Statistic stats::allocations("Allocations", "Alloc");
-Statistic stats::coveredInstructions("CoveredInstructions", "Icov");
-Statistic stats::falseBranches("FalseBranches", "Bf");
+Statistic stats::coveredInstructions("CoveredInstructions", "Icov", true);
+Statistic stats::falseBranches("FalseBranches", "Bf", true);
 Statistic stats::forkTime("ForkTime", "Ftime");
-Statistic stats::forks("Forks", "Forks");
-Statistic stats::instructionRealTime("InstructionRealTimes", "Ireal");
-Statistic stats::instructionTime("InstructionTimes", "Itime");
-Statistic stats::instructions("Instructions", "I");
-Statistic stats::minDistToReturn("MinDistToReturn", "Rdist");
-Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist");
+Statistic stats::forks("Forks", "Forks", true);
+Statistic stats::instructionRealTime("InstructionRealTimes", "Ireal", true);
+Statistic stats::instructionTime("InstructionTimes", "Itime", true);
+Statistic stats::instructions("Instructions", "I", true);
+Statistic stats::minDistToReturn("MinDistToReturn", "Rdist", true);
+Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist", true);
 Statistic stats::reachableUncovered("ReachableUncovered", "IuncovReach");
-Statistic stats::resolveTime("ResolveTime", "Rtime");
-Statistic stats::solverTime("SolverTime", "Stime");
-Statistic stats::states("States", "States");
-Statistic stats::trueBranches("TrueBranches", "Bt");
-Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov");
+Statistic stats::resolveTime("ResolveTime", "Rtime", true);
+Statistic stats::solverTime("SolverTime", "Stime", true);
+Statistic stats::states("States", "States", true);
+Statistic stats::trueBranches("TrueBranches", "Bt", true);
+Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov", true);
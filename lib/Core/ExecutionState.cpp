@@ -75,6 +75,8 @@ ExecutionState::ExecutionState(KFunction *kf) :
     suspendStatus(false),
     recoveryState(0),
     blockingLoadStatus(true),
+    pendingAllocations(0),
+    pendingAllocationsIndex(0),
 
     /* recovery state properties */
     exitInst(0),
@@ -132,6 +134,8 @@ ExecutionState::ExecutionState(const ExecutionState& state):
     writtenAddresses(state.writtenAddresses),
     pendingRecoveryInfos(state.pendingRecoveryInfos),
     recoveryCache(state.recoveryCache),
+    pendingAllocations(state.pendingAllocations),
+    pendingAllocationsIndex(state.pendingAllocationsIndex),
 
     /* recovery state properties */
     exitInst(state.exitInst),
@@ -163,6 +167,7 @@ ExecutionState::ExecutionState(const ExecutionState& state):
     coveredLines(state.coveredLines),
     ptreeNode(state.ptreeNode),
     symbolics(state.symbolics),
+    symbolicChunks(state.symbolicChunks),
     arrayNames(state.arrayNames)
 {
   for (unsigned int i=0; i<symbolics.size(); i++)
@@ -206,9 +211,11 @@ void ExecutionState::popFrame() {
   stack.pop_back();
 }
 
-void ExecutionState::addSymbolic(const MemoryObject *mo, const Array *array) { 
+void ExecutionState::addSymbolic(const MemoryObject *mo, const Array *array,
+                                 unsigned chunk) {
   mo->refCount++;
   symbolics.push_back(std::make_pair(mo, array));
+  symbolicChunks.push_back(chunk);
 }
 ///
 
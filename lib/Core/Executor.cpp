@@ -45,8 +45,10 @@
 #include "klee/Internal/Module/KModule.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 #include "klee/Internal/Support/FloatEvaluation.h"
+#include "klee/Internal/Support/PhaseTrace.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/System/MemoryUsage.h"
+#include "klee/Internal/System/PerfCounters.h"
 #include "klee/Internal/Support/Debug.h"
 #include "klee/SolverStats.h"
 
@@ -83,6 +85,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/InstIterator.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -127,6 +130,31 @@ using namespace klee;
 
 
 namespace {
+  cl::opt<bool>
+  TracePhases("trace-phases",
+              cl::desc("Record the executor phases (interpretation, solving, "
+                       "forking, recovery, slicing, test generation, stats) "
+                       "in trace.json, in the Chrome trace-event format "
+                       "(default=off)"),
+              cl::init(false));
+
+  cl::opt<bool>
+  PerfCounters("perf-counters",
+               cl::desc("Count cycles, instructions, LLC misses and branch "
+                        "misses per executor phase with perf_event_open, and "
+                        "add them to run.stats (default=off)"),
+               cl::init(false));
+
+  cl::opt<bool>
+  SolverCostReport("solver-cost-report",
+                   cl::desc("Attribute the solver time to the origin of the "
+                            "queries (branch, resolve, concretize, test "
+                            "generation, recovery check), to the recovery "
+                            "levels, to the skipped functions and to the "
+                            "original source lines, and write it to "
+                            "solver-costs.txt (default=off)"),
+                   cl::init(false));
+
   cl::opt<bool>
   DumpStatesOnHalt("dump-states-on-halt",
                    cl::init(true),
@@ -193,6 +221,50 @@ namespace {
   MaxSymArraySize("max-sym-array-size",
                   cl::init(0));
 
+  cl::opt<unsigned>
+  MaxMergedResolutions("max-merged-resolutions",
+                       cl::desc("Access the targets of a symbolic pointer which "
+                                "resolves to at most this many objects in a "
+                                "single state, through a select over the "
+                                "targets, instead of forking one state per "
+                                "target (default=0 (off))"),
+                       cl::init(0));
+
+  cl::opt<unsigned>
+  MaxMergedObjectSize("max-merged-object-size",
+                      cl::desc("Fork instead of merging when a target of a "
+                               "symbolic pointer is larger than this many "
+                               "bytes (default=4096)"),
+                      cl::init(4096));
+
+  cl::opt<bool>
+  SymbolicFieldArrays("symbolic-field-arrays",
+                      cl::desc("Back each field of a symbolic struct (as laid "
+                               "out by its allocated type) by a separate "
+                               "array (default=false)"),
+                      cl::init(false));
+
+  cl::opt<unsigned>
+  SymbolicChunkSize("symbolic-chunk-size",
+                    cl::desc("Back symbolic objects by separate arrays of at "
+                             "most this many bytes (default=0 (off))"),
+                    cl::init(0));
+
+  cl::opt<unsigned>
+  MaxExprNodes("max-expr-nodes",
+               cl::desc("Concretize the values bound to registers or written "
+                        "to memory whose expression has more than this many "
+                        "nodes, counting the updates of the arrays it reads "
+                        "(default=0 (off))"),
+               cl::init(0));
+
+  cl::opt<unsigned>
+  MaxExprDepth("max-expr-depth",
+               cl::desc("Concretize the values bound to registers or written "
+                        "to memory whose expression is deeper than this "
+                        "(default=0 (off))"),
+               cl::init(0));
+
   cl::opt<bool>
   SuppressExternalWarnings("suppress-external-warnings",
 			   cl::init(false),
@@ -232,6 +304,12 @@ namespace {
   OnlySeed("only-seed",
 	   cl::init(false),
            cl::desc("Stop execution after seeding is done without doing regular search (default=off)."));
+
+  cl::opt<bool>
+  SeedRecoveryStates("seed-recovery-states",
+                     cl::init(false),
+                     cl::desc("Replay the seeds in the recovery states of the seeded states, and resume the seeded states "
+                              "during seeding with the recovered values of the seeded path (default=off)."));
  
   cl::opt<bool>
   AllowSeedExtension("allow-seed-extension",
@@ -375,8 +453,9 @@ Executor::Executor(InterpreterOptions &opts, InterpreterHandler *ih)
     : Interpreter(opts), kmodule(0), interpreterHandler(ih), searcher(0),
       externalDispatcher(new ExternalDispatcher()), statsTracker(0),
       pathWriter(0), symPathWriter(0), specialFunctionHandler(0),
-      processTree(0), replayKTest(0), replayPath(0), usingSeeds(0),
-      atMemoryLimit(false), inhibitForking(false), haltExecution(false),
+      processTree(0), controlServer(0), replayKTest(0), replayPath(0), usingSeeds(0),
+      atMemoryLimit(false), memoryCheckPending(false), inhibitForking(false),
+      haltExecution(false),
       ivcEnabled(false),
       coreSolverTimeout(MaxCoreSolverTime != 0 && MaxInstructionTime != 0
                             ? std::min(MaxCoreSolverTime, MaxInstructionTime)
@@ -399,6 +478,8 @@ Executor::Executor(InterpreterOptions &opts, InterpreterHandler *ih)
       interpreterHandler->getOutputFilename(SOLVER_QUERIES_KQUERY_FILE_NAME));
 
   this->solver = new TimingSolver(solver, EqualitySubstitution);
+  if (SolverCostReport)
+    this->solver->costTracker = new SolverCostTracker();
   memory = new MemoryManager(&arrayCache);
 
   if (optionIsSet(DebugPrintInstructions, FILE_ALL) ||
@@ -486,7 +567,7 @@ const Module *Executor::setModule(llvm::Module *module,
     statsTracker = 
       new StatsTracker(*this,
                        interpreterHandler->getOutputFilename("assembly.ll"),
-                       userSearcherRequiresMD2U());
+                       userSearcherRequiresMD2U(), PerfCounters);
   }
 
   return module;
@@ -501,6 +582,8 @@ Executor::~Executor() {
     delete specialFunctionHandler;
   if (statsTracker)
     delete statsTracker;
+  if (controlServer)
+    delete controlServer;
   delete solver;
   /* TODO: is it the right place? */
   if (sliceGenerator) delete sliceGenerator;
@@ -754,6 +837,9 @@ void Executor::branch(ExecutionState &state,
                       const std::vector< ref<Expr> > &conditions,
                       std::vector<ExecutionState*> &result) {
   TimerStatIncrementer timer(stats::forkTime);
+  trace::PhaseScope tracePhase(trace::Fork);
+  perf::PhaseScope perfPhase(perf::Fork);
+  TimingSolver::OriginScope queryOrigin(solver, QO_Branch);
 
   unsigned N = conditions.size();
   assert(N);
@@ -769,6 +855,7 @@ void Executor::branch(ExecutionState &state,
     }
   } else {
     stats::forks += N-1;
+    memoryCheckPending = true;
 
     // XXX do proper balance or keep random?
     result.push_back(&state);
@@ -868,6 +955,7 @@ void Executor::branch(ExecutionState &state,
 
 Executor::StatePair 
 Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_Branch);
   Solver::Validity res;
   std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
     seedMap.find(&current);
@@ -1017,10 +1105,13 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
     return StatePair(0, &current);
   } else {
     TimerStatIncrementer timer(stats::forkTime);
+    trace::PhaseScope tracePhase(trace::Fork);
+    perf::PhaseScope perfPhase(perf::Fork);
     ExecutionState *falseState = NULL, *trueState = &current;
     ref<Expr> negatedCondition = Expr::createIsZero(condition);
 
     ++stats::forks;
+    memoryCheckPending = true;
     falseState = trueState->branch();
     addedStates.push_back(falseState);
     if (trueState->isRecoveryState()) {
@@ -1097,6 +1188,10 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
 
     if (trueState->isRecoveryState()) {
       forkDependentStates(trueState, falseState);
+      if (isSeeding && SeedRecoveryStates) {
+        inheritDependentSeeds(trueState);
+        inheritDependentSeeds(falseState);
+      }
 
       /* propagate constraints if required */
       mergeConstraintsForAll(*trueState, condition);
@@ -1223,7 +1318,7 @@ const Cell& Executor::eval(KInstruction *ki, unsigned index,
 
 void Executor::bindLocal(KInstruction *target, ExecutionState &state, 
                          ref<Expr> value) {
-  getDestCell(state, target).value = value;
+  getDestCell(state, target).value = limitComplexity(state, value);
 }
 
 void Executor::bindArgument(KFunction *kf, unsigned index, 
@@ -1233,6 +1328,7 @@ void Executor::bindArgument(KFunction *kf, unsigned index,
 
 ref<Expr> Executor::toUnique(const ExecutionState &state, 
                              ref<Expr> &e) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_Concretize);
   ref<Expr> result = e;
 
   if (!isa<ConstantExpr>(e)) {
@@ -1261,6 +1357,8 @@ Executor::toConstant(ExecutionState &state,
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(e))
     return CE;
 
+  TimingSolver::OriginScope queryOrigin(solver, QO_Concretize);
+
   ref<ConstantExpr> value;
   bool success = solver->getValue(state, e, value);
   assert(success && "FIXME: Unhandled solver failure");
@@ -1282,9 +1380,20 @@ Executor::toConstant(ExecutionState &state,
   return value;
 }
 
+ref<Expr> Executor::limitComplexity(ExecutionState &state, ref<Expr> e) {
+  if ((!MaxExprNodes && !MaxExprDepth) || isa<ConstantExpr>(e))
+    return e;
+
+  if (!exceedsComplexity(e, MaxExprNodes, MaxExprDepth))
+    return e;
+
+  return toConstant(state, e, "expression complexity limit");
+}
+
 void Executor::executeGetValue(ExecutionState &state,
                                ref<Expr> e,
                                KInstruction *target) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_Concretize);
   e = state.constraints.simplifyExpr(e);
   std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
     seedMap.find(&state);
@@ -1383,6 +1492,8 @@ void Executor::executeCall(ExecutionState &state,
   if (f && f->isDeclaration()) {
     switch(f->getIntrinsicID()) {
     case Intrinsic::not_intrinsic:
+      if (specialFunctionHandler->handleModel(state, f, ki, arguments))
+        break;
       // state may be destroyed by this call, cannot touch
       callExternalFunction(state, ki, f, arguments);
       break;
@@ -1479,24 +1590,34 @@ void Executor::executeCall(ExecutionState &state,
       return;
     }
 
+    if (specialFunctionHandler->handleModel(state, f, ki, arguments)) {
+      if (InvokeInst *ii = dyn_cast<InvokeInst>(i))
+        transferToBasicBlock(ii->getNormalDest(), i->getParent(), state);
+      return;
+    }
+
+    KFunction *kf = NULL;
+
     /* inject the sliced function if needed */
     if (state.isRecoveryState()) {
       ref<RecoveryInfo> recoveryInfo = state.getRecoveryInfo();
       if (UseSlicer) {
-        f = getSlice(f, recoveryInfo->sliceId, ModRefAnalysis::Modifier);
-        DEBUG_WITH_TYPE(
-          DEBUG_BASIC,
-          klee_message("injecting slice: %s", f->getName().data())
-        );
+        kf = getSliceCallTarget(i, f, recoveryInfo->sliceId);
 
         /* handle fully sliced functions */
-        if (f->isDeclaration()) {
+        if (!kf) {
           DEBUG_WITH_TYPE(
             DEBUG_BASIC,
             klee_message("ignoring fully sliced function: %s", f->getName().data())
           );
           return;
         }
+
+        f = kf->function;
+        DEBUG_WITH_TYPE(
+          DEBUG_BASIC,
+          klee_message("injecting slice: %s", f->getName().data())
+        );
       } else {
         /* we do it for consistent debugging... */
         DEBUG_WITH_TYPE(
@@ -1506,7 +1627,9 @@ void Executor::executeCall(ExecutionState &state,
       }
     }
 
-    KFunction *kf = kmodule->functionMap[f];
+    if (!kf) {
+      kf = kmodule->functionMap[f];
+    }
     state.pushFrame(state.prevPC, kf);
     state.pc = kf->instructions;
 
@@ -1820,6 +1943,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     break;
   }
   case Instruction::Switch: {
+    TimingSolver::OriginScope queryOrigin(solver, QO_Branch);
     SwitchInst *si = cast<SwitchInst>(i);
     ref<Expr> cond = eval(ki, 0, state).value;
     BasicBlock *bb = si->getParent();
@@ -2766,6 +2890,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
 void Executor::updateStates(ExecutionState *current) {
   if (searcher) {
+    perf::PhaseScope perfPhase(perf::Searcher);
     if (!removedStates.empty()) {
         /* we don't want to pass suspended states to the searcher */
         std::vector<ExecutionState *> filteredStates;
@@ -2885,15 +3010,22 @@ void Executor::bindModuleConstants() {
 void Executor::checkMemoryUsage() {
   if (!MaxMemory)
     return;
-  if ((stats::instructions & 0xFFFF) == 0) {
-    // We need to avoid calling GetTotalMallocUsage() often because it
-    // is O(elts on freelist). This is really bad since we start
-    // to pummel the freelist once we hit the memory cap.
+  // We need to avoid calling GetTotalMallocUsage() often because it
+  // is O(elts on freelist) with the default allocator. This is really bad
+  // since we start to pummel the freelist once we hit the memory cap.
+  // When the allocator keeps counters, the usage is also checked whenever
+  // states or snapshots were created, as these are where it jumps. Those
+  // checks only stop the forking, the states are killed at the periodic
+  // checks.
+  bool periodic = (stats::instructions & 0xFFFF) == 0;
+  bool pending = memoryCheckPending && util::IsMallocUsageCheap();
+  memoryCheckPending = false;
+  if (pending || periodic) {
     unsigned mbs = (util::GetTotalMallocUsage() >> 20) +
                    (memory->getUsedDeterministicSize() >> 20);
 
     if (mbs > MaxMemory) {
-      if (mbs > MaxMemory + 100) {
+      if (periodic && mbs > MaxMemory + 100) {
         // just guess at how many to kill
         unsigned numStates = states.size();
         unsigned toKill = std::max(1U, numStates - numStates * MaxMemory / mbs);
@@ -2938,6 +3070,29 @@ void Executor::doDumpStates() {
   updateStates(0);
 }
 
+/// Records the time in which a state is selected as an interpretation (or
+/// recovery) phase, see -trace-phases.
+static void traceSelectedState(ExecutionState *state) {
+  static ExecutionState *tracedState = 0;
+  static trace::Phase tracedPhase;
+
+  if (state == tracedState)
+    return;
+
+  if (tracedState)
+    trace::end(tracedPhase);
+  tracedState = state;
+  if (state) {
+    if (state->isRecoveryState()) {
+      tracedPhase = trace::Recovery;
+      trace::begin(tracedPhase, state, state->getLevel());
+    } else {
+      tracedPhase = trace::Interpret;
+      trace::begin(tracedPhase, state);
+    }
+  }
+}
+
 void Executor::run(ExecutionState &initialState) {
   bindModuleConstants();
 
@@ -2945,6 +3100,12 @@ void Executor::run(ExecutionState &initialState) {
   // optimization and such.
   initTimers();
 
+  if (TracePhases)
+    trace::open(interpreterHandler->getOutputFilename("trace.json"));
+
+  if (PerfCounters)
+    perf::start();
+
   states.insert(&initialState);
 
   if (usingSeeds) {
@@ -2967,6 +3128,22 @@ void Executor::run(ExecutionState &initialState) {
         seedMap.upper_bound(lastState);
       if (it == seedMap.end())
         it = seedMap.begin();
+
+      /* suspended states are waiting for their (seeded) recovery states */
+      std::map<ExecutionState*, std::vector<SeedInfo> >::iterator first = it;
+      while (SeedRecoveryStates && it->first->isNormalState() && it->first->isSuspended()) {
+        if (++it == seedMap.end())
+          it = seedMap.begin();
+        if (it == first)
+          break;
+      }
+      if (SeedRecoveryStates && it->first->isNormalState() && it->first->isSuspended()) {
+        /* their recovery states lost the seeds, so the seeds can't be followed */
+        klee_warning("%d seeded states are waiting for unseeded recovery states, dropping their seeds",
+                     (int) seedMap.size());
+        seedMap.clear();
+        break;
+      }
       lastState = it->first;
       unsigned numSeeds = it->second.size();
       ExecutionState &state = *lastState;
@@ -3018,12 +3195,24 @@ void Executor::run(ExecutionState &initialState) {
 
   searcher = constructUserSearcher(*this);
 
-  std::vector<ExecutionState *> newStates(states.begin(), states.end());
+  std::vector<ExecutionState *> newStates;
+  for (std::set<ExecutionState*>::iterator it = states.begin(), ie = states.end(); it != ie; ++it) {
+    /* seeding may stop while some states are suspended */
+    if (SeedRecoveryStates && (*it)->isNormalState() && (*it)->isSuspended())
+      continue;
+    newStates.push_back(*it);
+  }
   searcher->update(0, newStates, std::vector<ExecutionState *>());
 
   while (!states.empty() && !haltExecution) {
     assert(!searcher->empty());
+    if (perf::enabled)
+      perf::enter(perf::Searcher);
     ExecutionState &state = searcher->selectState();
+    if (perf::enabled)
+      perf::enter(state.isRecoveryState() ? perf::Recovery : perf::Interpreter);
+    if (trace::enabled)
+      traceSelectedState(&state);
     KInstruction *ki = state.pc;
     stepInstruction(state);
 
@@ -3035,6 +3224,9 @@ void Executor::run(ExecutionState &initialState) {
     updateStates(&state);
   }
 
+  if (trace::enabled)
+    traceSelectedState(0);
+
   delete searcher;
   searcher = 0;
 
@@ -3604,6 +3796,7 @@ void Executor::executeMemoryOperation(ExecutionState &state,
                                       ref<Expr> address,
                                       ref<Expr> value /* undef if read */,
                                       KInstruction *target /* undef if write */) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_Resolve);
   Expr::Width type = (isWrite ? value->getWidth() : 
                      getWidthForLLVMType(target->inst->getType()));
   unsigned bytes = Expr::getMinBytesForWidth(type);
@@ -3615,6 +3808,9 @@ void Executor::executeMemoryOperation(ExecutionState &state,
       value = state.constraints.simplifyExpr(value);
   }
 
+  if (isWrite)
+    value = limitComplexity(state, value);
+
   // fast path: single in-bounds resolution
   ObjectPair op;
   bool success;
@@ -3655,9 +3851,6 @@ void Executor::executeMemoryOperation(ExecutionState &state,
         } else {
           ObjectState *wos = state.addressSpace.getWriteable(mo, os);
           wos->write(offset, value);
-          if (state.isRecoveryState()) {
-            onRecoveryStateWrite(state, address, mo, offset, value);
-          }
           if (state.isNormalState()) {
             onNormalStateWrite(state, address, value);
           }
@@ -3687,6 +3880,11 @@ void Executor::executeMemoryOperation(ExecutionState &state,
                                                0, coreSolverTimeout);
   solver->setTimeout(0);
   
+  if (!incomplete &&
+      executeMergedMemoryOperation(state, isWrite, address, value, target,
+                                   rl, type))
+    return;
+
   // XXX there is some query wasteage here. who cares?
   ExecutionState *unbound = &state;
   
@@ -3730,6 +3928,147 @@ void Executor::executeMemoryOperation(ExecutionState &state,
   }
 }
 
+bool Executor::executeMergedMemoryOperation(ExecutionState &state,
+                                            bool isWrite,
+                                            ref<Expr> address,
+                                            ref<Expr> value,
+                                            KInstruction *target,
+                                            const ResolutionList &rl,
+                                            Expr::Width type) {
+  if (rl.size() < 2 || rl.size() > MaxMergedResolutions)
+    return false;
+
+  /* large objects are flushed to a symbolic array on each access, which
+     costs more than the forks */
+  for (ResolutionList::const_iterator i = rl.begin(), ie = rl.end(); i != ie;
+       ++i) {
+    if (i->first->size > MaxMergedObjectSize)
+      return false;
+    if (isWrite && i->second->readOnly)
+      return false;
+  }
+
+  unsigned bytes = Expr::getMinBytesForWidth(type);
+  std::vector< ref<Expr> > inBounds;
+  ref<Expr> anyInBounds = ConstantExpr::alloc(0, Expr::Bool);
+  for (ResolutionList::const_iterator i = rl.begin(), ie = rl.end(); i != ie;
+       ++i) {
+    inBounds.push_back(i->first->getBoundsCheckPointer(address, bytes));
+    anyInBounds = OrExpr::create(anyInBounds, inBounds.back());
+  }
+
+  /* a single fork for the out of bound case, instead of one per target */
+  StatePair branches = fork(state, anyInBounds, true);
+  if (branches.second)
+    terminateStateOnError(*branches.second,
+                          "memory error: out of bound pointer", Ptr, NULL,
+                          getAddressInfo(*branches.second, address));
+
+  ExecutionState *bound = branches.first;
+  if (!bound)
+    return true;
+
+  if (isWrite) {
+    /* every target is updated, with its old value where the pointer does
+       not point to it */
+    for (unsigned i = 0; i < rl.size(); i++) {
+      const MemoryObject *mo = rl[i].first;
+      const ObjectState *os = bound->addressSpace.findObject(mo);
+      ref<Expr> offset = mo->getOffsetExpr(address);
+      ref<Expr> old = os->read(offset, type);
+      ObjectState *wos = bound->addressSpace.getWriteable(mo, os);
+      wos->write(offset, SelectExpr::create(inBounds[i], value, old));
+    }
+  } else {
+    /* the last target is selected when the others are not, since the
+       pointer is known to be in bounds of one of them */
+    const MemoryObject *mo = rl.back().first;
+    const ObjectState *os = bound->addressSpace.findObject(mo);
+    ref<Expr> result = os->read(mo->getOffsetExpr(address), type);
+    for (int i = rl.size() - 2; i >= 0; i--) {
+      mo = rl[i].first;
+      os = bound->addressSpace.findObject(mo);
+      result = SelectExpr::create(inBounds[i],
+                                  os->read(mo->getOffsetExpr(address), type),
+                                  result);
+    }
+
+    if (interpreterOpts.MakeConcreteSymbolic)
+      result = replaceReadWithSymbolic(*bound, result);
+
+    bindLocal(target, *bound, result);
+  }
+
+  return true;
+}
+
+// Adds the offsets of the fields of an object of type t at the given
+// offset, recursively.
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+static void addFieldOffsets(const TargetData *targetData, Type *t,
+#else
+static void addFieldOffsets(const DataLayout *targetData, Type *t,
+#endif
+                            uint64_t offset, uint64_t size,
+                            std::set<uint64_t> &offsets) {
+  if (offset >= size)
+    return;
+
+  if (StructType *st = dyn_cast<StructType>(t)) {
+    const StructLayout *sl = targetData->getStructLayout(st);
+    for (unsigned i = 0; i < st->getNumElements(); i++) {
+      uint64_t fieldOffset = offset + sl->getElementOffset(i);
+      offsets.insert(fieldOffset);
+      addFieldOffsets(targetData, st->getElementType(i), fieldOffset, size,
+                      offsets);
+    }
+  } else if (ArrayType *at = dyn_cast<ArrayType>(t)) {
+    // the elements of arrays of scalars are not split
+    Type *elementType = at->getElementType();
+    if (!elementType->isAggregateType())
+      return;
+    uint64_t elementSize = targetData->getTypeAllocSize(elementType);
+    for (uint64_t i = 0; i < at->getNumElements(); i++) {
+      uint64_t elementOffset = offset + i * elementSize;
+      if (elementOffset >= size)
+        break;
+      offsets.insert(elementOffset);
+      addFieldOffsets(targetData, elementType, elementOffset, size, offsets);
+    }
+  }
+}
+
+void Executor::getSymbolicChunks(const MemoryObject *mo,
+                                 std::vector<unsigned> &offsets) {
+  std::set<uint64_t> split;
+  split.insert(0);
+
+  if (SymbolicFieldArrays && mo->allocSite) {
+    Type *t = 0;
+    if (const AllocaInst *ai = dyn_cast<AllocaInst>(mo->allocSite))
+      t = ai->getAllocatedType();
+    else if (const GlobalVariable *gv =
+               dyn_cast<GlobalVariable>(mo->allocSite))
+      t = gv->getType()->getElementType();
+    if (t)
+      addFieldOffsets(kmodule->targetData, t, 0, mo->size, split);
+  }
+
+  offsets.clear();
+  for (std::set<uint64_t>::iterator i = split.begin(); i != split.end(); i++) {
+    uint64_t end = mo->size;
+    std::set<uint64_t>::iterator next = i;
+    if (++next != split.end())
+      end = *next;
+
+    for (uint64_t offset = *i; offset < end; offset += SymbolicChunkSize) {
+      offsets.push_back(offset);
+      if (!SymbolicChunkSize)
+        break;
+    }
+  }
+}
+
 void Executor::executeMakeSymbolic(ExecutionState &state, 
                                    const MemoryObject *mo,
                                    const std::string &name) {
@@ -3742,9 +4081,40 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
     while (!state.arrayNames.insert(uniqueName).second) {
       uniqueName = name + "_" + llvm::utostr(++id);
     }
-    const Array *array = arrayCache.CreateArray(uniqueName, mo->size);
-    bindObjectInState(state, mo, false, array);
-    state.addSymbolic(mo, array);
+
+    // the object may be split in several arrays, so that the constraints
+    // on a part of it do not involve the others (the object is then bound
+    // with concrete contents, which are replaced by reads of the arrays)
+    std::vector<unsigned> chunks;
+    getSymbolicChunks(mo, chunks);
+    std::vector<const Array *> arrays;
+    if (chunks.size() == 1) {
+      const Array *array = arrayCache.CreateArray(uniqueName, mo->size);
+      bindObjectInState(state, mo, false, array);
+      arrays.push_back(array);
+    } else {
+      ObjectState *os = bindObjectInState(state, mo, false);
+      for (unsigned i = 0; i < chunks.size(); i++) {
+        unsigned end = i + 1 < chunks.size() ? chunks[i + 1] : mo->size;
+        std::string chunkName = uniqueName + "_" + llvm::utostr(chunks[i]);
+        for (unsigned id = 0; !state.arrayNames.insert(chunkName).second;)
+          chunkName = uniqueName + "_" + llvm::utostr(chunks[i]) + "_" +
+                      llvm::utostr(++id);
+
+        const Array *array = arrayCache.CreateArray(chunkName,
+                                                    end - chunks[i]);
+        UpdateList ul(array, 0);
+        for (unsigned offset = chunks[i]; offset < end; offset++)
+          os->write(offset,
+                    ReadExpr::create(ul, ConstantExpr::alloc(offset - chunks[i],
+                                                             Expr::Int32)));
+        arrays.push_back(array);
+      }
+    }
+    // the arrays of an object are consecutive in the symbolics, their
+    // values are concatenated for the test cases
+    for (unsigned i = 0; i < arrays.size(); i++)
+      state.addSymbolic(mo, arrays[i], i);
     
     std::map< ExecutionState*, std::vector<SeedInfo> >::iterator it = 
       seedMap.find(&state);
@@ -3754,11 +4124,13 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
              siie = it->second.end(); siit != siie; ++siit) {
         SeedInfo &si = *siit;
         KTestObject *obj = si.getNextInput(mo, NamedSeedMatching);
+        std::vector<unsigned char> values;
+        bool hasValues = false;
 
         if (!obj) {
           if (ZeroSeedExtension) {
-            std::vector<unsigned char> &values = si.assignment.bindings[array];
             values = std::vector<unsigned char>(mo->size, '\0');
+            hasValues = true;
           } else if (!AllowSeedExtension) {
             terminateStateOnError(state, "ran out of inputs during seeding",
                                   User);
@@ -3778,7 +4150,7 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
             terminateStateOnError(state, msg.str(), User);
             break;
           } else {
-            std::vector<unsigned char> &values = si.assignment.bindings[array];
+            hasValues = true;
             values.insert(values.begin(), obj->bytes, 
                           obj->bytes + std::min(obj->numBytes, mo->size));
             if (ZeroSeedExtension) {
@@ -3787,6 +4159,17 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
             }
           }
         }
+
+        if (!hasValues)
+          continue;
+        for (unsigned i = 0; i < arrays.size(); i++) {
+          unsigned begin = std::min((unsigned) values.size(), chunks[i]);
+          unsigned end = std::min((unsigned) values.size(),
+                                  begin + arrays[i]->size);
+          si.assignment.bindings[arrays[i]] =
+            std::vector<unsigned char>(values.begin() + begin,
+                                       values.begin() + end);
+        }
       }
     }
   } else {
@@ -3909,6 +4292,18 @@ void Executor::runFunctionAsMain(Function *f,
 
   if (statsTracker)
     statsTracker->done();
+
+  if (solver->costTracker) {
+    llvm::raw_ostream *os =
+        interpreterHandler->openOutputFile("solver-costs.txt");
+    if (os) {
+      solver->costTracker->writeReport(*os, *kmodule->infos);
+      delete os;
+    }
+  }
+
+  perf::stop();
+  trace::close();
 }
 
 unsigned Executor::getPathStreamID(const ExecutionState &state) {
@@ -3962,6 +4357,7 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
                                    std::pair<std::string,
                                    std::vector<unsigned char> > >
                                    &res) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_TestGeneration);
   solver->setTimeout(coreSolverTimeout);
 
   ExecutionState tmp(state);
@@ -3994,11 +4390,24 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
     if (pi!=pie) break;
   }
 
-  std::vector< std::vector<unsigned char> > values;
+  // Only the objects which occur in the constraints are given to the
+  // solver, the others get zero bytes. The solver chain solves each
+  // independent set of constraints separately (IndependentSolver), and
+  // reuses the solutions of the sets which did not change since they were
+  // solved for an ancestor (CexCachingSolver).
+  std::vector<const Array*> constrained;
+  findSymbolicObjects(tmp.constraints.begin(), tmp.constraints.end(),
+                      constrained);
+  std::set<const Array*> isConstrained(constrained.begin(),
+                                       constrained.end());
+
   std::vector<const Array*> objects;
   for (unsigned i = 0; i != state.symbolics.size(); ++i)
-    objects.push_back(state.symbolics[i].second);
-  bool success = solver->getInitialValues(tmp, objects, values);
+    if (isConstrained.count(state.symbolics[i].second))
+      objects.push_back(state.symbolics[i].second);
+
+  std::vector< std::vector<unsigned char> > solved;
+  bool success = solver->getInitialValues(tmp, objects, solved);
   solver->setTimeout(0);
   if (!success) {
     klee_warning("unable to compute initial values (invalid constraints?)!");
@@ -4006,9 +4415,25 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
                              ConstantExpr::alloc(0, Expr::Bool));
     return false;
   }
-  
-  for (unsigned i = 0; i != state.symbolics.size(); ++i)
-    res.push_back(std::make_pair(state.symbolics[i].first->name, values[i]));
+
+  std::vector< std::vector<unsigned char> > values;
+  for (unsigned i = 0, j = 0; i != state.symbolics.size(); ++i) {
+    const Array *array = state.symbolics[i].second;
+    if (isConstrained.count(array))
+      values.push_back(solved[j++]);
+    else
+      values.push_back(std::vector<unsigned char>(array->size));
+  }
+
+  for (unsigned i = 0; i != state.symbolics.size(); ++i) {
+    // the arrays of an object split by executeMakeSymbolic are concatenated
+    if (state.symbolicChunks[i] > 0)
+      res.back().second.insert(res.back().second.end(), values[i].begin(),
+                               values[i].end());
+    else
+      res.push_back(std::make_pair(state.symbolics[i].first->name,
+                                   values[i]));
+  }
   return true;
 }
 
@@ -4063,6 +4488,8 @@ Interpreter *Interpreter::create(InterpreterOptions &opts,
 }
 
 bool Executor::isMayBlockingLoad(ExecutionState &state, KInstruction *ki) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_RecoveryCheck);
+
   /* basic check based on static analysis */
   if (!ki->mayBlock) {
     return false;
@@ -4124,6 +4551,7 @@ bool Executor::isRecoveryRequired(ExecutionState &state, KInstruction *ki) {
 
 bool Executor::handleMayBlockingLoad(ExecutionState &state, KInstruction *ki,
                                      bool &success) {
+  TimingSolver::OriginScope queryOrigin(solver, QO_RecoveryCheck);
   success = true;
   /* find which slices should be executed... */
   std::list< ref<RecoveryInfo> > &recoveryInfos = state.getPendingRecoveryInfos();
@@ -4389,6 +4817,13 @@ void Executor::resumeState(ExecutionState &state, bool implicitlyCreated) {
   state.setResumed();
   state.setRecoveryState(0);
   state.markLoadAsUnrecovered();
+
+  /* bind the objects which were allocated by the recovery states */
+  bindPendingAllocations(state);
+  if (!state.isRecoveryState()) {
+    /* the originating state is the last one to consume the log */
+    state.setPendingAllocations(0, 0);
+  }
   if (implicitlyCreated) {
     DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("adding an implicitly created state: %p", &state));
     addedStates.push_back(&state);
@@ -4406,6 +4841,8 @@ void Executor::onRecoveryStateExit(ExecutionState &state) {
   ExecutionState *dependentState = state.getDependentState();
   //dumpConstrains(*dependentState);
 
+  transferRecoveredValue(state);
+
   /* check if we need to run another recovery state */
   if (dependentState->hasPendingRecoveryInfo()) {
     ref<RecoveryInfo> ri = dependentState->getPendingRecoveryInfo();
@@ -4416,6 +4853,55 @@ void Executor::onRecoveryStateExit(ExecutionState &state) {
   terminateState(state);
 }
 
+/* the recovery state is a copy of the snapshot state, so the bytes which
+   differ between their address spaces were written by the recovery state */
+void Executor::transferRecoveredValue(ExecutionState &state) {
+  ref<RecoveryInfo> recoveryInfo = state.getRecoveryInfo();
+  ExecutionState *dependentState = state.getDependentState();
+  bindPendingAllocations(*dependentState);
+
+  ObjectDeltas deltas;
+  recoveryInfo->snapshot->state->addressSpace.diff(state.addressSpace, deltas);
+  uint64_t changed = dependentState->addressSpace.applyDiff(deltas,
+                                                            recoveryInfo->loadAddr,
+                                                            recoveryInfo->loadSize);
+  DEBUG_WITH_TYPE(
+    DEBUG_BASIC,
+    klee_message("copying from %p to %p (%lu changed objects, %lu recovered bytes)",
+                 &state, dependentState, deltas.size(), changed)
+  );
+
+  /* the cache must replay what the dependent state got */
+  ref<Expr> value;
+  if (changed == recoveryInfo->loadSize) {
+    ObjectPair op;
+    ref<ConstantExpr> address = ConstantExpr::alloc(recoveryInfo->loadAddr,
+                                                    Context::get().getPointerWidth());
+    if (state.addressSpace.resolveOne(address, op) &&
+        recoveryInfo->loadSize <= op.first->size - (recoveryInfo->loadAddr - op.first->address)) {
+      value = op.second->read(recoveryInfo->loadAddr - op.first->address,
+                              recoveryInfo->loadSize * 8);
+    }
+  }
+
+  if (changed == 0) {
+    /* the slice does not modify the loaded value */
+    dependentState->updateRecoveredValue(recoveryInfo->snapshotIndex,
+                                         recoveryInfo->sliceId,
+                                         recoveryInfo->loadAddr, NULL);
+  } else if (!value.isNull()) {
+    dependentState->updateRecoveredValue(recoveryInfo->snapshotIndex,
+                                         recoveryInfo->sliceId,
+                                         recoveryInfo->loadAddr, value);
+  } else {
+    /* a partially written value can't be replayed by a single store, so the
+       slice will be executed again */
+    dependentState->clearRecoveredValue(recoveryInfo->snapshotIndex,
+                                        recoveryInfo->sliceId,
+                                        recoveryInfo->loadAddr);
+  }
+}
+
 void Executor::notifyDependentState(ExecutionState &recoveryState) {
   ExecutionState *dependentState = recoveryState.getDependentState();
   DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: notifying dependent state %p", &recoveryState, dependentState));
@@ -4446,8 +4932,14 @@ void Executor::startRecoveryState(ExecutionState &state, ref<RecoveryInfo> recov
 
   /* TODO: non-first snapshots hold normal state properties! */
 
+  /* the allocations of the recovery state are bound lazily to the dependent states */
+  if (state.getPendingAllocations().isNull()) {
+    state.setPendingAllocations(new PendingAllocations(), 0);
+  }
+
   /* initialize recovery state */
   ExecutionState *recoveryState = new ExecutionState(*snapshotState);
+  memoryCheckPending = true;
   if (recoveryInfo->snapshotIndex == 0) {
     /* a recovery state which is created from the first snapshot has no dependencies */
     recoveryState->setType(RECOVERY_STATE);
@@ -4471,6 +4963,10 @@ void Executor::startRecoveryState(ExecutionState &state, ref<RecoveryInfo> recov
     /* TODO: handle writtenAddresses */
 
     assert(recoveryState->getPendingRecoveryInfos().empty());
+
+    /* join the chain of dependent states, previous allocations are already visible */
+    ref<PendingAllocations> pendingAllocations = state.getPendingAllocations();
+    recoveryState->setPendingAllocations(pendingAllocations, pendingAllocations->size());
   }
 
   /* set exit instruction */
@@ -4499,6 +4995,14 @@ void Executor::startRecoveryState(ExecutionState &state, ref<RecoveryInfo> recov
   unsigned int level = state.isRecoveryState() ? state.getLevel() + 1 : 0;
   recoveryState->setLevel(level);
 
+  /* a seeded state waits for its recovery state, so the recovery state has to follow the seeds */
+  if (SeedRecoveryStates) {
+    std::map<ExecutionState*, std::vector<SeedInfo> >::iterator seeds = seedMap.find(&state);
+    if (seeds != seedMap.end()) {
+      seedMap[recoveryState] = seeds->second;
+    }
+  }
+
   /* add the guiding constraints to the recovery state */
   std::set< ref<Expr> > &constraints = originatingState->getGuidingConstraints();
   for (std::set< ref<Expr> >::iterator i = constraints.begin(); i != constraints.end(); i++) {
@@ -4540,63 +5044,6 @@ void Executor::startRecoveryState(ExecutionState &state, ref<RecoveryInfo> recov
 }
 
 /* TODO: handle vastart calls */
-void Executor::onRecoveryStateWrite(
-  ExecutionState &state,
-  ref<Expr> address,
-  const MemoryObject *mo,
-  ref<Expr> offset,
-  ref<Expr> value
-) {
-  assert(isa<ConstantExpr>(address));
-  assert(isa<ConstantExpr>(offset));
-
-  DEBUG_WITH_TYPE(
-    DEBUG_BASIC,
-    klee_message(
-      "write in state %p: mo = %p, address = %lx, size = %x, offset = %lx",
-      &state,
-      mo,
-      mo->address,
-      mo->size,
-      dyn_cast<ConstantExpr>(offset)->getZExtValue()
-    )
-  );
-
-  uint64_t storeAddr = dyn_cast<ConstantExpr>(address)->getZExtValue();
-  ref<RecoveryInfo> recoveryInfo = state.getRecoveryInfo();
-  if (storeAddr != recoveryInfo->loadAddr) {
-    return;
-  }
-
-  /* copy data to dependent state... */
-  ExecutionState *dependentState = state.getDependentState();
-  const ObjectState *os = dependentState->addressSpace.findObject(mo);
-  ObjectState *wos = dependentState->addressSpace.getWriteable(mo, os);
-  wos->write(offset, value);
-  DEBUG_WITH_TYPE(
-    DEBUG_BASIC,
-    klee_message("copying from %p to %p", &state, dependentState)
-  );
-
-  /* TODO: ... */
-  DEBUG_WITH_TYPE(
-    DEBUG_BASIC,
-    klee_message(
-      "%p: updating recovered value for %p (index = %u, slice id = %u)",
-      &state,
-      dependentState,
-      recoveryInfo->snapshotIndex,
-      recoveryInfo->sliceId
-    )
-  );
-  dependentState->updateRecoveredValue(
-    recoveryInfo->snapshotIndex,
-    recoveryInfo->sliceId,
-    storeAddr,
-    value
-  );
-}
-
 void Executor::onNormalStateWrite(
   ExecutionState &state,
   ref<Expr> address,
@@ -4803,44 +5250,61 @@ bool Executor::isFunctionToSkip(ExecutionState &state, Function *f) {
     return false;
 }
 
+/* the dependent states share the log, and bind the object when they resume */
 void Executor::bindAll(ExecutionState *state, MemoryObject *mo, bool isLocal, bool zeroMemory) {
-    ExecutionState *next;
-    do {
-        /* this state is a normal state (and might be a recovery state as well) */
-        next = NULL;
-        if (state->isRecoveryState()) {
-            next = state->getDependentState();
+    DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: pending binding of address: %lx", state, mo->address));
+    state->getPendingAllocations()->addAlloc(mo, isLocal, zeroMemory);
+}
+
+void Executor::unbindAll(ExecutionState *state, const MemoryObject *mo) {
+    DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: pending unbinding of address %lx", state, mo->address));
+    state->getPendingAllocations()->addFree(mo);
+}
+
+void Executor::bindPendingAllocations(ExecutionState &state) {
+    ref<PendingAllocations> pendingAllocations = state.getPendingAllocations();
+    if (pendingAllocations.isNull()) {
+        return;
+    }
+
+    unsigned int index = state.getPendingAllocationsIndex();
+    for (; index < pendingAllocations->size(); index++) {
+        const PendingAllocations::Entry &entry = pendingAllocations->getEntry(index);
+        const MemoryObject *mo = entry.mo;
+
+        if (entry.isFree) {
+            DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: unbinding address %lx", &state, mo->address));
+            state.addressSpace.unbindObject(mo);
+            continue;
         }
 
-        DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: binding address: %lx", state, mo->address));
-        if (!state->addressSpace.findObject(mo)) {
-            ObjectState *os = bindObjectInState(*state, mo, isLocal);
+        DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: binding address: %lx", &state, mo->address));
+        if (!state.addressSpace.findObject(mo)) {
+            ObjectState *os = bindObjectInState(state, mo, entry.isLocal);
             /* initialize allocated object */
-            if (zeroMemory) {
+            if (entry.zeroMemory) {
                 os->initializeToZero();
             } else {
                 os->initializeToRandom();
             }
         }
+    }
 
-        state = next;
-    } while (next);
+    state.setPendingAllocations(pendingAllocations, index);
 }
 
-void Executor::unbindAll(ExecutionState *state, const MemoryObject *mo) {
-    ExecutionState *next;
+/* a dependent state follows the seeds of its recovery state */
+void Executor::inheritDependentSeeds(ExecutionState *recoveryState) {
+    std::map<ExecutionState*, std::vector<SeedInfo> >::iterator seeds = seedMap.find(recoveryState);
+    ExecutionState *dependent = recoveryState;
     do {
-        /* this state is a normal state (and might be a recovery state as well) */
-        next = NULL;
-        if (state->isRecoveryState()) {
-            next = state->getDependentState();
+        dependent = dependent->getDependentState();
+        if (seeds != seedMap.end()) {
+            seedMap[dependent] = seeds->second;
+        } else {
+            seedMap.erase(dependent);
         }
-
-        DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("%p: unbinding address %lx", state, mo->address));
-        state->addressSpace.unbindObject(mo);
-
-        state = next;
-    } while (next);
+    } while (dependent->isRecoveryState());
 }
 
 void Executor::forkDependentStates(ExecutionState *trueState, ExecutionState *falseState) {
@@ -4849,10 +5313,19 @@ void Executor::forkDependentStates(ExecutionState *trueState, ExecutionState *fa
     ExecutionState *prevForked = falseState;
     ExecutionState *forkedOriginatingState = NULL;
 
+    /* from now on, the forked chain logs its own allocations */
+    ref<PendingAllocations> forkedPendingAllocations(
+        new PendingAllocations(*current->getPendingAllocations())
+    );
+    if (falseState->isNormalState()) {
+        falseState->setPendingAllocations(forkedPendingAllocations, falseState->getPendingAllocationsIndex());
+    }
+
     /* fork the chain of dependent states */
     do {
         forked = new ExecutionState(*current);
         assert(forked->isSuspended());
+        forked->setPendingAllocations(forkedPendingAllocations, forked->getPendingAllocationsIndex());
         DEBUG_WITH_TYPE(DEBUG_BASIC, klee_message("forked dependent state: %p (from %p)", forked, current));
 
         if (forked->isRecoveryState()) {
@@ -4916,9 +5389,14 @@ Function *Executor::getSlice(Function *target, uint32_t sliceId, ModRefAnalysis:
 
     sliceInfo = cloner->getSliceInfo(target, sliceId);
     if (!sliceInfo || !sliceInfo->isSliced) {
+        trace::PhaseScope tracePhase(trace::Slicing);
         DEBUG_WITH_TYPE(DEBUG_BASIC,
             klee_message("generating slice for: %s (id = %u)", target->getName().data(), sliceId)
         );
+        /* the statistics jobs read the module, which is extended below */
+        if (statsTracker) {
+            statsTracker->waitForService();
+        }
         sliceGenerator->generateSlice(target, sliceId, type);
         sliceGenerator->dumpSlice(target, sliceId, true);
 
@@ -4968,14 +5446,97 @@ Function *Executor::getSlice(Function *target, uint32_t sliceId, ModRefAnalysis:
         }
     }
 
+    /* the slice might have been generated eagerly (non-lazy mode) */
+    if (callRedirectionTables.find(sliceId) == callRedirectionTables.end()) {
+        buildCallRedirectionTable(target, sliceId);
+    }
+
     return sliceInfo->f;
 }
 
+/* resolve the direct call sites of a slice once, so recovery states don't have to */
+void Executor::buildCallRedirectionTable(Function *target, uint32_t sliceId) {
+    CallRedirectionTable &table = callRedirectionTables[sliceId];
+
+    std::set<Function *> &reachable = ra->getReachableFunctions(target);
+    for (std::set<Function *>::iterator i = reachable.begin(); i != reachable.end(); i++) {
+        Function *f = *i;
+        if (f->isDeclaration()) {
+            continue;
+        }
+
+        Function *cloned = cloner->getSliceInfo(f, sliceId)->f;
+        if (cloned->isDeclaration()) {
+            continue;
+        }
+
+        for (inst_iterator j = inst_begin(cloned), je = inst_end(cloned); j != je; j++) {
+            CallSite cs(&*j);
+            if (!cs) {
+                continue;
+            }
+
+            /* indirect calls are resolved on demand */
+            Function *callee = cs.getCalledFunction();
+            if (!callee || callee->isDeclaration()) {
+                continue;
+            }
+
+            Cloner::SliceInfo *calleeInfo = cloner->getSliceInfo(callee, sliceId);
+            if (!calleeInfo || !calleeInfo->isSliced) {
+                continue;
+            }
+
+            CallRedirection &redirection = table[cs.getInstruction()];
+            redirection.target = callee;
+            if (calleeInfo->f->isDeclaration()) {
+                /* fully sliced, the call is skipped */
+                redirection.kf = NULL;
+            } else {
+                redirection.kf = kmodule->functionMap[calleeInfo->f];
+            }
+        }
+    }
+
+    DEBUG_WITH_TYPE(DEBUG_BASIC,
+        klee_message("call redirection table for slice %u: %lu call sites", sliceId, table.size())
+    );
+}
+
+KFunction *Executor::getSliceCallTarget(Instruction *callInst, Function *target, uint32_t sliceId) {
+    CallRedirectionTables::iterator i = callRedirectionTables.find(sliceId);
+    if (i != callRedirectionTables.end()) {
+        CallRedirectionTable &table = i->second;
+        CallRedirectionTable::iterator j = table.find(callInst);
+        /* the target may differ for function pointers and aliases */
+        if (j != table.end() && j->second.target == target) {
+            return j->second.kf;
+        }
+    }
+
+    /* the slice entry, or a call site which was not resolved statically */
+    Function *sliced = getSlice(target, sliceId, ModRefAnalysis::Modifier);
+
+    CallRedirection &redirection = callRedirectionTables[sliceId][callInst];
+    redirection.target = target;
+    if (sliced->isDeclaration()) {
+        redirection.kf = NULL;
+    } else {
+        redirection.kf = kmodule->functionMap[sliced];
+    }
+
+    return redirection.kf;
+}
+
 ExecutionState *Executor::createSnapshotState(ExecutionState &state) {
     ExecutionState *snapshotState = new ExecutionState(state);
+    memoryCheckPending = true;
 
     /* remove guiding constraints */
     snapshotState->clearGuidingConstraints();
 
+    /* a recovery state joins the chain with its own index */
+    snapshotState->setPendingAllocations(0, 0);
+
     return snapshotState;
 }
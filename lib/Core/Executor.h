@@ -60,6 +60,7 @@ namespace llvm {
 namespace klee {  
   class Array;
   struct Cell;
+  class ControlServer;
   class ExecutionState;
   class ExternalDispatcher;
   class Expr;
@@ -91,6 +92,7 @@ class Executor : public Interpreter {
   friend class RandomPathSearcher;
   friend class OwningSearcher;
   friend class WeightedRandomSearcher;
+  friend class DirectedSearcher;
   friend class RandomRecoveryPath;
   friend class SpecialFunctionHandler;
   friend class StatsTracker;
@@ -141,6 +143,10 @@ private:
   std::vector<TimerInfo*> timers;
   PTree *processTree;
 
+  /// Answers the commands sent to the control socket, or null if it is
+  /// disabled. \see processControlRequests()
+  ControlServer *controlServer;
+
   /// Used to track states that have been added during the current
   /// instructions step. 
   /// \invariant \ref addedStates is a subset of \ref states. 
@@ -189,6 +195,11 @@ private:
   /// needed to control memory usage. \see fork()
   bool atMemoryLimit;
 
+  /// Set when states or snapshots are created, so that the memory usage
+  /// is checked after the current instruction, if it is cheap to probe.
+  /// \see checkMemoryUsage()
+  bool memoryCheckPending;
+
   /// Disables forking, set by client. \see setInhibitForking()
   bool inhibitForking;
 
@@ -226,6 +237,16 @@ private:
   Cloner *cloner;
   SliceGenerator *sliceGenerator;
 
+  /* the resolved target of a call site in a slice (NULL if fully sliced) */
+  struct CallRedirection {
+    llvm::Function *target;
+    KFunction *kf;
+  };
+  typedef std::map<llvm::Instruction *, CallRedirection> CallRedirectionTable;
+  typedef std::map<uint32_t, CallRedirectionTable> CallRedirectionTables;
+  /* computed once per slice, used by recovery states to dispatch calls */
+  CallRedirectionTables callRedirectionTables;
+
   unsigned int errorCount;
 
   llvm::raw_ostream *logFile;
@@ -323,6 +344,24 @@ private:
                               ref<Expr> value /* undef if read */,
                               KInstruction *target /* undef if write */);
 
+  /// Performs a memory operation on all the targets of a symbolic pointer
+  /// in a single state (the value read is a select over the targets, and
+  /// each target is updated conditionally). Returns false if the
+  /// resolution is too large to be merged, in which case nothing is done.
+  bool executeMergedMemoryOperation(ExecutionState &state,
+                                    bool isWrite,
+                                    ref<Expr> address,
+                                    ref<Expr> value,
+                                    KInstruction *target,
+                                    const ResolutionList &rl,
+                                    Expr::Width type);
+
+  /// Return the offsets at which a symbolic object is split in separate
+  /// arrays (see -symbolic-field-arrays and -symbolic-chunk-size), the
+  /// first one being 0.
+  void getSymbolicChunks(const MemoryObject *mo,
+                         std::vector<unsigned> &offsets);
+
   void executeMakeSymbolic(ExecutionState &state, const MemoryObject *mo,
                            const std::string &name);
 
@@ -387,6 +426,11 @@ private:
   ref<klee::ConstantExpr> toConstant(ExecutionState &state, ref<Expr> e, 
                                      const char *purpose);
 
+  /// Concretize e (as toConstant does) if it exceeds the size or the
+  /// depth given by -max-expr-nodes and -max-expr-depth, otherwise
+  /// return it unchanged.
+  ref<Expr> limitComplexity(ExecutionState &state, ref<Expr> e);
+
   /// Bind a constant value for e to the given target. NOTE: This
   /// function may fork state if the state has multiple seeds.
   void executeGetValue(ExecutionState &state, ref<Expr> e, KInstruction *target);
@@ -449,6 +493,9 @@ private:
   void initTimers();
   void processTimers(ExecutionState *current,
                      double maxInstTime);
+  void processControlRequests();
+  std::string handleControlCommand(const std::string &command);
+  void printControlStats(llvm::raw_ostream &os);
   void checkMemoryUsage();
   void printDebugInstructions(ExecutionState &state);
   void doDumpStates();
@@ -466,14 +513,8 @@ private:
   void resumeState(ExecutionState &state, bool implicitlyCreated);
   void notifyDependentState(ExecutionState &recoveryState);
   void onRecoveryStateExit(ExecutionState &state);
+  void transferRecoveredValue(ExecutionState &state);
   void startRecoveryState(ExecutionState &state, ref<RecoveryInfo> recoveryInfo);
-  void onRecoveryStateWrite(
-    ExecutionState &state,
-    ref<Expr> address,
-    const MemoryObject *mo,
-    ref<Expr> offset,
-    ref<Expr> value
-  );
   void onNormalStateWrite(
     ExecutionState &state,
     ref<Expr> address,
@@ -495,9 +536,13 @@ private:
   bool canSkipCallSite(ExecutionState &state, llvm::Function *f);
   void bindAll(ExecutionState *state, MemoryObject *mo, bool isLocal, bool zeroMemory);
   void unbindAll(ExecutionState *state, const MemoryObject *mo);
+  void bindPendingAllocations(ExecutionState &state);
   void forkDependentStates(ExecutionState *trueState, ExecutionState *falseState);
+  void inheritDependentSeeds(ExecutionState *recoveryState);
   void mergeConstraintsForAll(ExecutionState &recoveryState, ref<Expr> condition);
   llvm::Function *getSlice(llvm::Function *target, uint32_t sliceId, ModRefAnalysis::SideEffectType type);
+  void buildCallRedirectionTable(llvm::Function *target, uint32_t sliceId);
+  KFunction *getSliceCallTarget(llvm::Instruction *callInst, llvm::Function *target, uint32_t sliceId);
   ExecutionState *createSnapshotState(ExecutionState &state);
 
 public:
@@ -508,6 +553,10 @@ public:
     return *interpreterHandler;
   }
 
+  const InterpreterOptions::ErrorLocations &getErrorLocations() const {
+    return interpreterOpts.errorLocations;
+  }
+
   // XXX should just be moved out to utility module
   ref<klee::ConstantExpr> evalConstant(const llvm::Constant *c);
 
@@ -7,9 +7,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ControlServer.h"
 #include "CoreStats.h"
 #include "Executor.h"
 #include "PTree.h"
+#include "Searcher.h"
 #include "StatsTracker.h"
 #include "ExecutorTimerInfo.h"
 
@@ -17,8 +19,10 @@
 #include "klee/Internal/Module/InstructionInfoTable.h"
 #include "klee/Internal/Module/KInstruction.h"
 #include "klee/Internal/Module/KModule.h"
+#include "klee/Internal/System/MemoryUsage.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/Support/ErrorHandling.h"
+#include "klee/SolverStats.h"
 
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
 #include "llvm/IR/Function.h"
@@ -42,6 +46,12 @@ MaxTime("max-time",
         cl::desc("Halt execution after the specified number of seconds (default=0 (off))"),
         cl::init(0));
 
+cl::opt<bool>
+ControlSocket("control-socket",
+              cl::desc("Accept control commands on the Unix domain socket "
+                       "control.sock in the output directory (default=off)"),
+              cl::init(false));
+
 ///
 
 class HaltTimer : public Executor::Timer {
@@ -95,6 +105,15 @@ void Executor::initTimers() {
   if (MaxTime) {
     addTimer(new HaltTimer(this), MaxTime.getValue());
   }
+
+  if (ControlSocket && !controlServer) {
+    controlServer =
+        new ControlServer(interpreterHandler->getOutputFilename("control.sock"));
+    if (!controlServer->start()) {
+      delete controlServer;
+      controlServer = 0;
+    }
+  }
 }
 
 ///
@@ -112,6 +131,9 @@ void Executor::processTimers(ExecutionState *current,
   static unsigned callsWithoutCheck = 0;
   unsigned ticks = timerTicks;
 
+  if (controlServer && controlServer->hasRequests())
+    processControlRequests();
+
   if (!ticks && ++callsWithoutCheck > 1000) {
     setupHandler();
     ticks = 1;
@@ -205,3 +227,128 @@ void Executor::processTimers(ExecutionState *current,
   }
 }
 
+
+///
+
+void Executor::processControlRequests() {
+  ControlServer::Request request;
+  while (controlServer->popRequest(request))
+    ControlServer::reply(request, handleControlCommand(request.command));
+}
+
+/// Executes a command received on the control socket, and returns the
+/// response (a single line).
+std::string Executor::handleControlCommand(const std::string &command) {
+  std::string response;
+  llvm::raw_string_ostream os(response);
+
+  std::vector<std::string> args;
+  std::string::size_type pos = 0;
+  while (pos < command.size()) {
+    std::string::size_type start = command.find_first_not_of(" \t", pos);
+    if (start == std::string::npos)
+      break;
+    pos = command.find_first_of(" \t", start);
+    if (pos == std::string::npos)
+      pos = command.size();
+    args.push_back(command.substr(start, pos - start));
+  }
+
+  if (args.empty()) {
+    os << "error: empty command";
+  } else if (args[0] == "stats" && args.size() == 1) {
+    printControlStats(os);
+  } else if (args[0] == "halt" && args.size() == 1) {
+    klee_message("halting execution (requested on the control socket)");
+    setHaltExecution(true);
+    os << "ok";
+  } else if (args[0] == "stop-forking" && args.size() == 1) {
+    setInhibitForking(true);
+    os << "ok";
+  } else if (args[0] == "dump-states" && args.size() == 1) {
+    /* handled below by processTimers() */
+    dumpStates = 1;
+    os << "ok: " << interpreterHandler->getOutputFilename("states.txt");
+  } else if (args[0] == "dump-tree" && args.size() == 1) {
+    llvm::raw_ostream *tree = interpreterHandler->openOutputFile("ptree.dot");
+    if (tree) {
+      processTree->dump(*tree);
+      delete tree;
+      os << "ok: " << interpreterHandler->getOutputFilename("ptree.dot");
+    } else {
+      os << "error: unable to open ptree.dot";
+    }
+  } else if (args[0] == "ticks" && args.size() == 1) {
+    os << timerTicks;
+  } else if (args[0] == "checkpoint" && args.size() == 1) {
+    if (statsTracker) {
+      statsTracker->checkpoint();
+      os << "ok";
+    } else {
+      os << "error: statistics are disabled";
+    }
+  } else if (args[0] == "set" && args.size() == 3) {
+    char *end;
+    unsigned long value = strtoul(args[2].c_str(), &end, 10);
+    if (args[2].empty() || *end != '\0') {
+      os << "error: invalid value: " << args[2];
+    } else if (!searcher) {
+      os << "error: the searcher is not running yet";
+    } else if (!searcher->setParameter(args[1], value)) {
+      os << "error: the searcher does not accept " << args[1] << "="
+         << args[2];
+    } else {
+      klee_message("%s set to %lu (requested on the control socket)",
+                   args[1].c_str(), value);
+      os << "ok";
+    }
+  } else {
+    os << "error: unknown command: " << command;
+  }
+
+  return os.str();
+}
+
+/// Prints the current statistics as a single line of JSON.
+void Executor::printControlStats(llvm::raw_ostream &os) {
+  unsigned normal = 0, suspended = 0, recovery = 0;
+  std::set<Snapshot *> snapshots;
+  for (std::set<ExecutionState *>::const_iterator it = states.begin(),
+                                                  ie = states.end();
+       it != ie; ++it) {
+    ExecutionState *es = *it;
+    if (es->isRecoveryState()) {
+      recovery++;
+      continue;
+    }
+    if (!es->isNormalState())
+      continue;
+
+    if (es->isSuspended())
+      suspended++;
+    else
+      normal++;
+
+    std::vector<ref<Snapshot> > &stateSnapshots = es->getSnapshots();
+    for (std::vector<ref<Snapshot> >::iterator i = stateSnapshots.begin();
+         i != stateSnapshots.end(); ++i)
+      snapshots.insert(i->get());
+  }
+
+  os << "{";
+  os << "\"elapsed\": "
+     << (statsTracker ? statsTracker->elapsed() : 0.0) << ", ";
+  os << "\"instructions\": " << stats::instructions << ", ";
+  os << "\"states\": {";
+  os << "\"normal\": " << normal << ", ";
+  os << "\"suspended\": " << suspended << ", ";
+  os << "\"recovery\": " << recovery << "}, ";
+  os << "\"snapshots\": " << snapshots.size() << ", ";
+  os << "\"queries\": " << stats::queries << ", ";
+  os << "\"solverTime\": " << stats::solverTime / 1000000. << ", ";
+  os << "\"memory\": " << util::GetTotalMallocUsage() << ", ";
+  os << "\"coveredInstructions\": " << stats::coveredInstructions << ", ";
+  os << "\"uncoveredInstructions\": " << stats::uncoveredInstructions << ", ";
+  os << "\"halted\": " << (haltExecution ? "true" : "false");
+  os << "}";
+}
@@ -34,6 +34,7 @@ class MemoryObject {
   friend class ObjectState;
   friend class ExecutionState;
   friend class AllocationRecord;
+  friend class PendingAllocations;
 
 private:
   static int counter;
@@ -0,0 +1,50 @@
+#include "Memory.h"
+#include "klee/PendingAllocations.h"
+
+#include <cassert>
+#include <vector>
+
+namespace klee {
+
+PendingAllocations::PendingAllocations(const PendingAllocations &other) :
+    refCount(0),
+    entries(other.entries)
+{
+    for (std::vector<Entry>::iterator i = entries.begin(); i != entries.end(); i++) {
+        i->mo->refCount++;
+    }
+}
+
+PendingAllocations::~PendingAllocations() {
+    for (std::vector<Entry>::iterator i = entries.begin(); i != entries.end(); i++) {
+        const MemoryObject *mo = i->mo;
+        assert(mo->refCount > 0);
+        mo->refCount--;
+        if (mo->refCount == 0) {
+            delete mo;
+        }
+    }
+}
+
+void PendingAllocations::addAlloc(const MemoryObject *mo, bool isLocal, bool zeroMemory) {
+    add(mo, isLocal, zeroMemory, false);
+}
+
+void PendingAllocations::addFree(const MemoryObject *mo) {
+    add(mo, false, false, true);
+}
+
+void PendingAllocations::add(const MemoryObject *mo, bool isLocal, bool zeroMemory, bool isFree) {
+    Entry entry = {
+        .mo = mo,
+        .isLocal = isLocal,
+        .zeroMemory = zeroMemory,
+        .isFree = isFree
+    };
+    entries.push_back(entry);
+
+    /* the object must outlive the log, even if it is unbound everywhere */
+    mo->refCount++;
+}
+
+}
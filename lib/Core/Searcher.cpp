@@ -26,10 +26,12 @@
 #include "klee/Internal/Support/ErrorHandling.h"
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #else
 #include "llvm/Constants.h"
+#include "llvm/InlineAsm.h"
 #include "llvm/Instructions.h"
 #include "llvm/Module.h"
 #endif
@@ -37,8 +39,10 @@
 
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
 #include "llvm/Support/CallSite.h"
+#include "llvm/Support/CFG.h"
 #else
 #include "llvm/IR/CallSite.h"
+#include "llvm/IR/CFG.h"
 #endif
 
 #include <cassert>
@@ -275,6 +279,290 @@ bool WeightedRandomSearcher::empty() {
 
 ///
 
+static std::vector<Instruction *> getSuccessors(Instruction *i) {
+  BasicBlock *bb = i->getParent();
+  std::vector<Instruction *> res;
+
+  if (i == bb->getTerminator()) {
+    for (succ_iterator it = succ_begin(bb), ie = succ_end(bb); it != ie; ++it)
+      res.push_back(it->begin());
+  } else {
+    res.push_back(++BasicBlock::iterator(i));
+  }
+
+  return res;
+}
+
+DirectedSearcher::DirectedSearcher(Executor &_executor)
+  : executor(_executor),
+    states(new DiscretePDF<ExecutionState*>()),
+    targetsCount(0) {
+  computeCallTargets();
+  computeDistances();
+}
+
+DirectedSearcher::~DirectedSearcher() {
+  delete states;
+}
+
+void DirectedSearcher::computeCallTargets() {
+  KModule *km = executor.kmodule;
+  Module *m = km->module;
+
+  /* indirect calls may target any escaping function (as in the StatsTracker) */
+  for (Module::iterator f = m->begin(); f != m->end(); f++) {
+    for (Function::iterator bb = f->begin(); bb != f->end(); bb++) {
+      for (BasicBlock::iterator i = bb->begin(); i != bb->end(); i++) {
+        if (!isa<CallInst>(i) && !isa<InvokeInst>(i)) {
+          continue;
+        }
+
+        CallSite cs(i);
+        std::vector<Function *> &targets = callTargets[i];
+        if (isa<InlineAsm>(cs.getCalledValue())) {
+          continue;
+        }
+
+        if (Function *target = getDirectCallTarget(cs)) {
+          targets.push_back(target);
+        } else {
+          targets.insert(targets.end(),
+                         km->escapingFunctions.begin(),
+                         km->escapingFunctions.end());
+        }
+      }
+    }
+  }
+}
+
+bool DirectedSearcher::isTarget(Instruction *inst) {
+  const InstructionInfo &ii = executor.kmodule->infos->getInfo(inst);
+  if (ii.file.empty()) {
+    return false;
+  }
+
+  std::string basename = ii.file.substr(ii.file.find_last_of("/\\") + 1);
+  const InterpreterOptions::ErrorLocations &errorLocations = executor.getErrorLocations();
+  InterpreterOptions::ErrorLocations::const_iterator entry = errorLocations.find(basename);
+  if (entry == errorLocations.end()) {
+    return false;
+  }
+
+  /* no lines means the whole file */
+  const std::vector<unsigned> &lines = entry->second;
+  return lines.empty() || std::find(lines.begin(), lines.end(), ii.line) != lines.end();
+}
+
+void DirectedSearcher::computeDistances() {
+  Module *m = executor.kmodule->module;
+  std::vector<Instruction *> instructions;
+
+  for (Module::iterator f = m->begin(); f != m->end(); f++) {
+    if (f->isDeclaration()) {
+      functionDistToReturn[f] = f->doesNotReturn() ? 0 : 1;
+      functionDistToTarget[f] = 0;
+      continue;
+    }
+
+    functionDistToReturn[f] = 0;
+    functionDistToTarget[f] = 0;
+    for (Function::iterator bb = f->begin(); bb != f->end(); bb++) {
+      for (BasicBlock::iterator i = bb->begin(); i != bb->end(); i++) {
+        instructions.push_back(i);
+        distToReturn[i] = isa<ReturnInst>(i) ? 1 : 0;
+        if (isTarget(i)) {
+          distToTarget[i] = 1;
+          targetsCount++;
+        } else {
+          distToTarget[i] = 0;
+        }
+      }
+    }
+  }
+
+  /* backward propagation converges faster */
+  std::reverse(instructions.begin(), instructions.end());
+
+  /* shortest paths to a return instruction */
+  bool changed;
+  do {
+    changed = false;
+    for (std::vector<Instruction *>::iterator it = instructions.begin();
+         it != instructions.end(); it++) {
+      Instruction *inst = *it;
+      uint64_t through = 1;
+      if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
+        through = 0;
+        std::vector<Function *> &targets = callTargets[inst];
+        for (std::vector<Function *>::iterator f = targets.begin(); f != targets.end(); f++) {
+          uint64_t d = functionDistToReturn[*f];
+          if (d && (!through || d + 1 < through)) {
+            through = d + 1;
+          }
+        }
+      }
+      if (!through) {
+        continue;
+      }
+
+      uint64_t &best = distToReturn[inst];
+      std::vector<Instruction *> succs = getSuccessors(inst);
+      for (std::vector<Instruction *>::iterator s = succs.begin(); s != succs.end(); s++) {
+        uint64_t d = distToReturn[*s];
+        if (d && (!best || through + d < best)) {
+          best = through + d;
+          changed = true;
+        }
+      }
+
+      Function *f = inst->getParent()->getParent();
+      if (inst == f->begin()->begin() && functionDistToReturn[f] != best) {
+        functionDistToReturn[f] = best;
+        changed = true;
+      }
+    }
+  } while (changed);
+
+  /* shortest paths to a target, either locally or through a callee */
+  do {
+    changed = false;
+    for (std::vector<Instruction *>::iterator it = instructions.begin();
+         it != instructions.end(); it++) {
+      Instruction *inst = *it;
+      uint64_t &best = distToTarget[inst];
+      uint64_t through = 1;
+      if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
+        through = 0;
+        std::vector<Function *> &targets = callTargets[inst];
+        for (std::vector<Function *>::iterator f = targets.begin(); f != targets.end(); f++) {
+          uint64_t d = functionDistToReturn[*f];
+          if (d && (!through || d + 1 < through)) {
+            through = d + 1;
+          }
+
+          d = functionDistToTarget[*f];
+          if (d && (!best || d + 1 < best)) {
+            best = d + 1;
+            changed = true;
+          }
+        }
+      }
+
+      if (through) {
+        std::vector<Instruction *> succs = getSuccessors(inst);
+        for (std::vector<Instruction *>::iterator s = succs.begin(); s != succs.end(); s++) {
+          uint64_t d = distToTarget[*s];
+          if (d && (!best || through + d < best)) {
+            best = through + d;
+            changed = true;
+          }
+        }
+      }
+
+      Function *f = inst->getParent()->getParent();
+      if (inst == f->begin()->begin() && functionDistToTarget[f] != best) {
+        functionDistToTarget[f] = best;
+        changed = true;
+      }
+    }
+  } while (changed);
+
+  unsigned int unreachable = 0;
+  for (std::map<Function *, uint64_t>::iterator i = functionDistToTarget.begin();
+       i != functionDistToTarget.end(); i++) {
+    if (!i->first->isDeclaration() && i->second == 0) {
+      unreachable++;
+    }
+  }
+  klee_message("directed search: %u target instructions, %u functions can not reach a target",
+               targetsCount, unreachable);
+}
+
+uint64_t DirectedSearcher::getDistanceAfterCall(DistanceMap &m, Instruction *inst) {
+  uint64_t best = 0;
+  std::vector<Instruction *> succs = getSuccessors(inst);
+  for (std::vector<Instruction *>::iterator s = succs.begin(); s != succs.end(); s++) {
+    DistanceMap::iterator i = m.find(*s);
+    if (i != m.end() && i->second && (!best || i->second < best)) {
+      best = i->second;
+    }
+  }
+  return best;
+}
+
+uint64_t DirectedSearcher::getDistance(ExecutionState *es) {
+  /* instructions which were added after the construction (lazy slicing) are
+   * treated as unreachable */
+  DistanceMap::iterator i = distToTarget.find(es->pc->inst);
+  if (i != distToTarget.end() && i->second) {
+    return i->second;
+  }
+
+  /* the target may still be reachable after returning to one of the callers */
+  i = distToReturn.find(es->pc->inst);
+  if (i == distToReturn.end() || !i->second) {
+    return 0;
+  }
+
+  uint64_t acc = i->second;
+  for (unsigned int index = es->stack.size() - 1; index > 0; index--) {
+    KInstIterator caller = es->stack[index].caller;
+    if (!caller) {
+      break;
+    }
+
+    uint64_t d = getDistanceAfterCall(distToTarget, caller->inst);
+    if (d) {
+      return acc + d;
+    }
+
+    d = getDistanceAfterCall(distToReturn, caller->inst);
+    if (!d) {
+      break;
+    }
+    acc += d;
+  }
+
+  return 0;
+}
+
+double DirectedSearcher::getWeight(ExecutionState *es) {
+  uint64_t d = getDistance(es);
+  double inv = 1. / (d ? d : 10000);
+  return inv * inv;
+}
+
+ExecutionState &DirectedSearcher::selectState() {
+  return *states->choose(theRNG.getDoubleL());
+}
+
+void DirectedSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  if (current &&
+      std::find(removedStates.begin(), removedStates.end(), current) ==
+          removedStates.end())
+    states->update(current, getWeight(current));
+
+  for (std::vector<ExecutionState *>::const_iterator it = addedStates.begin(),
+                                                     ie = addedStates.end();
+       it != ie; ++it) {
+    states->insert(*it, getWeight(*it));
+  }
+
+  for (std::vector<ExecutionState *>::const_iterator it = removedStates.begin(),
+                                                     ie = removedStates.end();
+       it != ie; ++it) {
+    states->remove(*it);
+  }
+}
+
+bool DirectedSearcher::empty() {
+  return states->empty();
+}
+
+///
+
 RandomPathSearcher::RandomPathSearcher(Executor &_executor)
   : executor(_executor) {
 }
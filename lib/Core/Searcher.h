@@ -54,6 +54,12 @@ namespace klee {
     virtual void activate() {}
     virtual void deactivate() {}
 
+    // changes a parameter of a running searcher (see -control-socket),
+    // returns false if the searcher does not have such a parameter
+    virtual bool setParameter(const std::string &name, unsigned value) {
+      return false;
+    }
+
     // utility functions
 
     void addState(ExecutionState *es, ExecutionState *current = 0) {
@@ -78,7 +84,8 @@ namespace klee {
       NURS_Depth,
       NURS_ICnt,
       NURS_CPICnt,
-      NURS_QC
+      NURS_QC,
+      NURS_Directed
     };
 
     enum RecoverySearchType {
@@ -170,6 +177,46 @@ namespace klee {
     }
   };
 
+  /* Weighted random search which prefers the states which are closest to one
+   * of the locations given by -error-location. The distance of an instruction
+   * is the length of the shortest path (through the CFG and the call graph)
+   * leading to a target instruction, and is computed once at construction.
+   */
+  class DirectedSearcher : public Searcher {
+    typedef std::map<llvm::Instruction *, uint64_t> DistanceMap;
+
+    Executor &executor;
+    DiscretePDF<ExecutionState*> *states;
+
+    /* 0 means unreachable, as in the StatsTracker */
+    DistanceMap distToTarget;
+    DistanceMap distToReturn;
+    std::map<llvm::Function *, uint64_t> functionDistToReturn;
+    std::map<llvm::Function *, uint64_t> functionDistToTarget;
+    std::map<llvm::Instruction *, std::vector<llvm::Function *> > callTargets;
+    unsigned int targetsCount;
+
+    void computeCallTargets();
+    bool isTarget(llvm::Instruction *inst);
+    void computeDistances();
+    uint64_t getDistanceAfterCall(DistanceMap &m, llvm::Instruction *inst);
+    uint64_t getDistance(ExecutionState *es);
+    double getWeight(ExecutionState *es);
+
+  public:
+    DirectedSearcher(Executor &executor);
+    ~DirectedSearcher();
+
+    ExecutionState &selectState();
+    void update(ExecutionState *current,
+                const std::vector<ExecutionState *> &addedStates,
+                const std::vector<ExecutionState *> &removedStates);
+    bool empty();
+    void printName(llvm::raw_ostream &os) {
+      os << "DirectedSearcher (" << targetsCount << " target instructions)\n";
+    }
+  };
+
   class RandomPathSearcher : public Searcher {
     Executor &executor;
 
@@ -208,6 +255,9 @@ namespace klee {
     void printName(llvm::raw_ostream &os) {
       os << "MergingSearcher\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      return baseSearcher->setParameter(name, value);
+    }
   };
 
   class BumpMergingSearcher : public Searcher {
@@ -231,6 +281,9 @@ namespace klee {
     void printName(llvm::raw_ostream &os) {
       os << "BumpMergingSearcher\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      return baseSearcher->setParameter(name, value);
+    }
   };
 
   class BatchingSearcher : public Searcher {
@@ -260,6 +313,9 @@ namespace klee {
       baseSearcher->printName(os);
       os << "</BatchingSearcher>\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      return baseSearcher->setParameter(name, value);
+    }
   };
 
   class IterativeDeepeningTimeSearcher : public Searcher {
@@ -279,6 +335,9 @@ namespace klee {
     void printName(llvm::raw_ostream &os) {
       os << "IterativeDeepeningTimeSearcher\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      return baseSearcher->setParameter(name, value);
+    }
   };
 
   class InterleavedSearcher : public Searcher {
@@ -304,6 +363,13 @@ namespace klee {
         (*it)->printName(os);
       os << "</InterleavedSearcher>\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      bool accepted = false;
+      for (searchers_ty::iterator it = searchers.begin(), ie = searchers.end();
+           it != ie; ++it)
+        accepted |= (*it)->setParameter(name, value);
+      return accepted;
+    }
   };
 
   class SplittedSearcher : public Searcher {
@@ -326,6 +392,18 @@ namespace klee {
       os << "- recovery searcher: "; recoverySearcher->printName(os);
       os << "- ratio = " << ratio << "\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      if (name == "split-ratio") {
+        if (value > 100)
+          return false;
+        ratio = value;
+        return true;
+      }
+      /* the parameters of the underlying searchers */
+      bool accepted = baseSearcher->setParameter(name, value);
+      accepted |= recoverySearcher->setParameter(name, value);
+      return accepted;
+    }
   };
 
   class RandomRecoveryPath : public Searcher {
@@ -383,6 +461,19 @@ namespace klee {
       os << "- high priority searcher: "; highPrioritySearcher->printName(os);
       os << "- ratio = " << ratio << "\n";
     }
+    bool setParameter(const std::string &name, unsigned value) {
+      if (name == "split-ratio") {
+        if (value > 100)
+          return false;
+        ratio = value;
+        return true;
+      }
+      /* the parameters of the underlying searchers */
+      bool accepted = baseSearcher->setParameter(name, value);
+      accepted |= recoverySearcher->setParameter(name, value);
+      accepted |= highPrioritySearcher->setParameter(name, value);
+      return accepted;
+    }
   };
 }
 
@@ -0,0 +1,159 @@
+//===-- SolverCostTracker.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SolverCostTracker.h"
+
+#include "klee/ExecutionState.h"
+#include "klee/Internal/Module/InstructionInfoTable.h"
+#include "klee/Internal/Module/KInstruction.h"
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace klee;
+
+namespace {
+
+const char *originNames[NumQueryOrigins] = {
+  "other", "branch", "resolve", "concretize", "test generation",
+  "recovery check"
+};
+
+struct LineCosts {
+  const std::string *file;
+  unsigned line;
+  Function *f;
+  SolverCostTracker::OriginCosts costs;
+  uint64_t time;
+
+  LineCosts() : file(0), line(0), f(0), time(0) {}
+};
+
+bool moreExpensive(const LineCosts *a, const LineCosts *b) {
+  return a->time > b->time;
+}
+
+typedef std::pair<Function *, SolverCostTracker::Cost> FunctionCost;
+
+bool moreExpensiveFunction(const FunctionCost &a, const FunctionCost &b) {
+  return a.second.time > b.second.time;
+}
+
+void writeCost(raw_ostream &os, const SolverCostTracker::Cost &cost) {
+  os << cost.queries << " " << format("%.6f", cost.time / 1000000.);
+}
+
+}
+
+void SolverCostTracker::record(QueryOrigin origin, const ExecutionState &state,
+                               uint64_t time) {
+  byOrigin[origin].add(time);
+
+  if (state.isRecoveryState()) {
+    byLevel[state.getLevel()].add(time);
+    bySkippedFunction[state.getRecoveryInfo()->f].add(time);
+  } else {
+    byLevel[-1].add(time);
+  }
+
+  /* slice instructions are charged to the instructions they were cloned
+     from, and the instructions inserted by the slicer are not charged */
+  KInstruction *ki = state.prevPC;
+  if (ki && ki->getOrigInst())
+    byInst[ki->getOrigInst()].costs[origin].add(time);
+}
+
+void SolverCostTracker::writeReport(raw_ostream &os,
+                                    const InstructionInfoTable &infos) const {
+  os << "# queries time(s)\n";
+
+  os << "\n[origin]\n";
+  for (unsigned i = 0; i < NumQueryOrigins; i++) {
+    os << originNames[i] << ": ";
+    writeCost(os, byOrigin[i]);
+    os << "\n";
+  }
+
+  os << "\n[level]\n";
+  for (std::map<int, Cost>::const_iterator i = byLevel.begin();
+       i != byLevel.end(); i++) {
+    if (i->first < 0)
+      os << "normal: ";
+    else
+      os << "recovery " << i->first << ": ";
+    writeCost(os, i->second);
+    os << "\n";
+  }
+
+  os << "\n[skipped function]\n";
+  std::vector<FunctionCost> functions(bySkippedFunction.begin(),
+                                      bySkippedFunction.end());
+  std::sort(functions.begin(), functions.end(), moreExpensiveFunction);
+  for (std::vector<FunctionCost>::iterator i = functions.begin();
+       i != functions.end(); i++) {
+    os << (i->first ? i->first->getName() : StringRef("<unknown>")) << ": ";
+    writeCost(os, i->second);
+    os << "\n";
+  }
+
+  /* aggregate the instructions of each source line */
+  std::map<std::pair<const std::string *, unsigned>, LineCosts> lines;
+  for (std::map<Instruction *, OriginCosts>::const_iterator i = byInst.begin();
+       i != byInst.end(); i++) {
+    const InstructionInfo &info = infos.getInfo(i->first);
+    LineCosts &lc = lines[std::make_pair(&info.file, info.line)];
+    lc.file = &info.file;
+    lc.line = info.line;
+    lc.f = i->first->getParent()->getParent();
+    for (unsigned o = 0; o < NumQueryOrigins; o++) {
+      lc.costs.costs[o].queries += i->second.costs[o].queries;
+      lc.costs.costs[o].time += i->second.costs[o].time;
+      lc.time += i->second.costs[o].time;
+    }
+  }
+
+  std::vector<const LineCosts *> sorted;
+  for (std::map<std::pair<const std::string *, unsigned>,
+                LineCosts>::const_iterator i = lines.begin();
+       i != lines.end(); i++)
+    sorted.push_back(&i->second);
+  std::sort(sorted.begin(), sorted.end(), moreExpensive);
+
+  os << "\n[line]\n";
+  os << "# file:line function total";
+  for (unsigned o = 0; o < NumQueryOrigins; o++)
+    os << " | " << originNames[o];
+  os << "\n";
+  for (std::vector<const LineCosts *>::iterator i = sorted.begin();
+       i != sorted.end(); i++) {
+    const LineCosts &lc = **i;
+    Cost total;
+    for (unsigned o = 0; o < NumQueryOrigins; o++) {
+      total.queries += lc.costs.costs[o].queries;
+      total.time += lc.costs.costs[o].time;
+    }
+
+    os << (lc.file->empty() ? "<unknown>" : *lc.file) << ":" << lc.line
+       << " " << lc.f->getName() << " ";
+    writeCost(os, total);
+    for (unsigned o = 0; o < NumQueryOrigins; o++) {
+      os << " | ";
+      writeCost(os, lc.costs.costs[o]);
+    }
+    os << "\n";
+  }
+}
@@ -0,0 +1,79 @@
+//===-- SolverCostTracker.h -------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SOLVERCOSTTRACKER_H
+#define KLEE_SOLVERCOSTTRACKER_H
+
+#include "llvm/Support/DataTypes.h"
+
+#include <map>
+
+namespace llvm {
+  class Function;
+  class Instruction;
+  class raw_ostream;
+}
+
+namespace klee {
+  class ExecutionState;
+  class InstructionInfoTable;
+
+  /// The reason for which the executor queries the solver.
+  enum QueryOrigin {
+    QO_Other,
+    QO_Branch,
+    QO_Resolve,
+    QO_Concretize,
+    QO_TestGeneration,
+    QO_RecoveryCheck,
+    NumQueryOrigins
+  };
+
+  /// SolverCostTracker - Attributes the solver time to the origin of the
+  /// queries, to the recovery level of the querying state, to the original
+  /// (not cloned) instruction which caused them and to the skipped function
+  /// which a recovery state executes.
+  class SolverCostTracker {
+  public:
+    struct Cost {
+      uint64_t queries;
+      /// in microseconds
+      uint64_t time;
+
+      Cost() : queries(0), time(0) {}
+
+      void add(uint64_t t) {
+        queries++;
+        time += t;
+      }
+    };
+
+    struct OriginCosts {
+      Cost costs[NumQueryOrigins];
+    };
+
+  private:
+    Cost byOrigin[NumQueryOrigins];
+    /// -1 is used for the normal states
+    std::map<int, Cost> byLevel;
+    std::map<llvm::Instruction *, OriginCosts> byInst;
+    std::map<llvm::Function *, Cost> bySkippedFunction;
+
+  public:
+    void record(QueryOrigin origin, const ExecutionState &state,
+                uint64_t time);
+
+    /// Writes the costs, with the source lines and the skipped functions
+    /// sorted by decreasing solver time.
+    void writeReport(llvm::raw_ostream &os,
+                     const InstructionInfoTable &infos) const;
+  };
+}
+
+#endif
@@ -24,11 +24,18 @@
 #include "klee/CommandLine.h"
 
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #else
+#include "llvm/Instructions.h"
 #include "llvm/Module.h"
 #endif
 #include "llvm/ADT/Twine.h"
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+#include "llvm/Support/CallSite.h"
+#else
+#include "llvm/IR/CallSite.h"
+#endif
 
 #if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
 #include "llvm/Target/TargetData.h"
@@ -56,6 +63,23 @@ namespace {
                    cl::desc("Silently terminate paths with an infeasible "
                             "condition given to klee_assume() rather than "
                             "emitting an error (default=false)"));
+
+  cl::opt<bool>
+  NativeStringFunctions("native-string-functions",
+                        cl::init(false),
+                        cl::desc("Execute strlen, strchr, memchr, strcmp, "
+                                 "strncmp and memcmp natively, building a "
+                                 "single expression for their result instead "
+                                 "of forking at each symbolic byte "
+                                 "(default=false)"));
+
+  cl::opt<unsigned>
+  NativeStringMaxSymbolicBytes("native-string-max-symbolic-bytes",
+                               cl::init(64),
+                               cl::desc("Execute the library function instead "
+                                        "of its native model if it reads more "
+                                        "symbolic bytes than this "
+                                        "(default=64)"));
 }
 
 
@@ -144,6 +168,21 @@ static SpecialFunctionHandler::HandlerInfo handlerInfo[] = {
 #undef add  
 };
 
+// Models of read-only library functions. Unlike the handlers, the bodies
+// of these functions are kept: a model may not apply (see handleModel), in
+// which case the function is executed.
+static struct {
+  const char *name;
+  SpecialFunctionHandler::Model model;
+} modelInfo[] = {
+  { "memchr", &SpecialFunctionHandler::modelMemchr },
+  { "memcmp", &SpecialFunctionHandler::modelMemcmp },
+  { "strchr", &SpecialFunctionHandler::modelStrchr },
+  { "strcmp", &SpecialFunctionHandler::modelStrcmp },
+  { "strlen", &SpecialFunctionHandler::modelStrlen },
+  { "strncmp", &SpecialFunctionHandler::modelStrncmp },
+};
+
 SpecialFunctionHandler::const_iterator SpecialFunctionHandler::begin() {
   return SpecialFunctionHandler::const_iterator(handlerInfo);
 }
@@ -213,6 +252,20 @@ void SpecialFunctionHandler::bind() {
     if (f && (!hi.doNotOverride || f->isDeclaration()))
       handlers[f] = std::make_pair(hi.handler, hi.hasReturnValue);
   }
+
+  if (NativeStringFunctions) {
+    for (unsigned i = 0; i < sizeof(modelInfo)/sizeof(modelInfo[0]); ++i) {
+      Function *f = executor.kmodule->module->getFunction(modelInfo[i].name);
+      if (f)
+        models[f] = modelInfo[i].model;
+    }
+  }
+
+  // the scan functions created by -summarize-loops
+  Module *m = executor.kmodule->module;
+  for (Module::iterator f = m->begin(), fe = m->end(); f != fe; ++f)
+    if (f->getName().startswith("__klee_loop_scan") && !f->isDeclaration())
+      models[f] = &SpecialFunctionHandler::modelLoopScan;
 }
 
 
@@ -237,6 +290,25 @@ bool SpecialFunctionHandler::handle(ExecutionState &state,
   }
 }
 
+bool SpecialFunctionHandler::handleModel(ExecutionState &state,
+                                         Function *f,
+                                         KInstruction *target,
+                                         std::vector< ref<Expr> > &arguments) {
+  models_ty::iterator it = models.find(f);
+  if (it == models.end())
+    return false;
+
+  // the memory read by recovery states, and by states which depend on
+  // skipped functions, may have to be recovered first, which is done by the
+  // loads of the function
+  if (state.isRecoveryState() ||
+      (state.isNormalState() && state.isInDependentMode()))
+    return false;
+
+  Model m = it->second;
+  return (this->*m)(state, target, arguments);
+}
+
 /****/
 
 // reads a concrete string from memory
@@ -781,3 +853,413 @@ void SpecialFunctionHandler::handleDivRemOverflow(ExecutionState &state,
   executor.terminateStateOnError(state, "overflow on division or remainder",
                                  Executor::Overflow);
 }
+
+/* Models */
+
+namespace {
+  /// The positions of a scan which may stop it, in order.
+  struct Scan {
+    std::vector< ref<Expr> > conditions;
+    std::vector< ref<Expr> > values;
+    /// None of the positions so far stops the scan
+    ref<Expr> noStop;
+    /// A position always stops the scan
+    bool done;
+
+    Scan() : noStop(ConstantExpr::create(1, Expr::Bool)), done(false) {}
+
+    void add(ref<Expr> condition, ref<Expr> value) {
+      if (condition->isFalse())
+        return;
+
+      conditions.push_back(condition);
+      values.push_back(value);
+      if (condition->isTrue()) {
+        noStop = ConstantExpr::create(0, Expr::Bool);
+        done = true;
+      } else {
+        noStop = AndExpr::create(noStop, Expr::createIsZero(condition));
+      }
+    }
+  };
+
+  /// Counts the symbolic bytes read by a model.
+  bool tooManySymbolicBytes(ref<Expr> byte, unsigned &count) {
+    return !isa<ConstantExpr>(byte) && ++count > NativeStringMaxSymbolicBytes;
+  }
+
+  ref<Expr> byteDifference(ref<Expr> a, ref<Expr> b, Expr::Width width) {
+    return SubExpr::create(ZExtExpr::create(a, width),
+                           ZExtExpr::create(b, width));
+  }
+}
+
+bool SpecialFunctionHandler::resolveBuffer(ExecutionState &state,
+                                           ref<Expr> address,
+                                           ObjectPair &op,
+                                           uint64_t &offset) {
+  address = state.constraints.simplifyExpr(address);
+  ConstantExpr *ce = dyn_cast<ConstantExpr>(address);
+  if (!ce || !state.addressSpace.resolveOne(ce, op))
+    return false;
+
+  offset = ce->getZExtValue() - op.first->address;
+  return offset < op.first->size;
+}
+
+// Returns the n argument of a model if it is concrete.
+static bool getConstantSize(Executor &executor, ExecutionState &state,
+                            ref<Expr> n, uint64_t &size) {
+  n = executor.toUnique(state, n);
+  if (ConstantExpr *ce = dyn_cast<ConstantExpr>(n)) {
+    size = ce->getZExtValue();
+    return true;
+  }
+  return false;
+}
+
+void SpecialFunctionHandler::bindScanResult(ExecutionState &state,
+                                            KInstruction *target,
+                                            const std::vector< ref<Expr> >
+                                              &conditions,
+                                            const std::vector< ref<Expr> >
+                                              &values,
+                                            ref<Expr> tail,
+                                            ref<Expr> noStop,
+                                            ref<Expr> address) {
+  ref<Expr> result = tail;
+  for (unsigned i = conditions.size(); i > 0; i--)
+    result = SelectExpr::create(conditions[i - 1], values[i - 1], result);
+
+  if (noStop->isFalse()) {
+    executor.bindLocal(target, state, result);
+    return;
+  }
+
+  Executor::StatePair branches = executor.fork(state, noStop, true);
+  if (branches.first)
+    executor.terminateStateOnError(*branches.first,
+                                   "memory error: out of bound pointer",
+                                   Executor::Ptr, NULL,
+                                   executor.getAddressInfo(*branches.first,
+                                                           address));
+  if (branches.second)
+    executor.bindLocal(target, *branches.second, result);
+}
+
+bool SpecialFunctionHandler::modelStrlen(ExecutionState &state,
+                                         KInstruction *target,
+                                         std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 1)
+    return false;
+
+  ObjectPair op;
+  uint64_t offset;
+  if (!resolveBuffer(state, arguments[0], op, offset))
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  unsigned symbolic = 0;
+  Scan scan;
+  for (uint64_t i = offset; i < op.first->size && !scan.done; i++) {
+    ref<Expr> byte = op.second->read8(i);
+    if (tooManySymbolicBytes(byte, symbolic))
+      return false;
+    scan.add(Expr::createIsZero(byte),
+             ConstantExpr::create(i - offset, width));
+  }
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 ConstantExpr::create(0, width), scan.noStop, arguments[0]);
+  return true;
+}
+
+bool SpecialFunctionHandler::modelStrchr(ExecutionState &state,
+                                         KInstruction *target,
+                                         std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 2)
+    return false;
+
+  ObjectPair op;
+  uint64_t offset;
+  if (!resolveBuffer(state, arguments[0], op, offset))
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  ref<Expr> c = ExtractExpr::create(arguments[1], 0, Expr::Int8);
+  unsigned symbolic = 0;
+  Scan scan;
+  for (uint64_t i = offset; i < op.first->size && !scan.done; i++) {
+    ref<Expr> byte = op.second->read8(i);
+    if (tooManySymbolicBytes(byte, symbolic))
+      return false;
+    // the terminator is found as well if c is zero
+    scan.add(EqExpr::create(byte, c),
+             AddExpr::create(arguments[0],
+                             ConstantExpr::create(i - offset, width)));
+    scan.add(Expr::createIsZero(byte), Expr::createPointer(0));
+  }
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 Expr::createPointer(0), scan.noStop, arguments[0]);
+  return true;
+}
+
+bool SpecialFunctionHandler::modelMemchr(ExecutionState &state,
+                                         KInstruction *target,
+                                         std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 3)
+    return false;
+
+  ObjectPair op;
+  uint64_t offset, n;
+  if (!resolveBuffer(state, arguments[0], op, offset) ||
+      !getConstantSize(executor, state, arguments[2], n) ||
+      n > op.first->size - offset)
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  ref<Expr> c = ExtractExpr::create(arguments[1], 0, Expr::Int8);
+  unsigned symbolic = 0;
+  Scan scan;
+  for (uint64_t i = 0; i < n && !scan.done; i++) {
+    ref<Expr> byte = op.second->read8(offset + i);
+    if (tooManySymbolicBytes(byte, symbolic))
+      return false;
+    scan.add(EqExpr::create(byte, c),
+             AddExpr::create(arguments[0], ConstantExpr::create(i, width)));
+  }
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 Expr::createPointer(0), ConstantExpr::create(0, Expr::Bool),
+                 arguments[0]);
+  return true;
+}
+
+// Compares two strings, up to n characters if n is given.
+static bool compareStrings(std::vector<ref<Expr> > &arguments,
+                           const ObjectPair &op1, uint64_t offset1,
+                           const ObjectPair &op2, uint64_t offset2,
+                           const uint64_t *n, Expr::Width width,
+                           Scan &scan, ref<Expr> &end) {
+  unsigned symbolic = 0;
+  uint64_t i = 0;
+  for (; !scan.done && (!n || i < *n); i++) {
+    if (offset1 + i >= op1.first->size) {
+      end = arguments[0];
+      return true;
+    }
+    if (offset2 + i >= op2.first->size) {
+      end = arguments[1];
+      return true;
+    }
+
+    ref<Expr> a = op1.second->read8(offset1 + i);
+    ref<Expr> b = op2.second->read8(offset2 + i);
+    if (tooManySymbolicBytes(a, symbolic) ||
+        tooManySymbolicBytes(b, symbolic))
+      return false;
+    scan.add(NeExpr::create(a, b), byteDifference(a, b, width));
+    scan.add(Expr::createIsZero(a), ConstantExpr::create(0, width));
+  }
+
+  // the strings are equal up to n
+  scan.noStop = ConstantExpr::create(0, Expr::Bool);
+  end = arguments[0];
+  return true;
+}
+
+bool SpecialFunctionHandler::modelStrcmp(ExecutionState &state,
+                                         KInstruction *target,
+                                         std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 2)
+    return false;
+
+  ObjectPair op1, op2;
+  uint64_t offset1, offset2;
+  if (!resolveBuffer(state, arguments[0], op1, offset1) ||
+      !resolveBuffer(state, arguments[1], op2, offset2))
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  Scan scan;
+  ref<Expr> end;
+  if (!compareStrings(arguments, op1, offset1, op2, offset2, NULL,
+                      width, scan, end))
+    return false;
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 ConstantExpr::create(0, width), scan.noStop, end);
+  return true;
+}
+
+bool SpecialFunctionHandler::modelStrncmp(ExecutionState &state,
+                                          KInstruction *target,
+                                          std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 3)
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  ObjectPair op1, op2;
+  uint64_t offset1, offset2, n;
+  if (!getConstantSize(executor, state, arguments[2], n))
+    return false;
+  if (n == 0) {
+    executor.bindLocal(target, state, ConstantExpr::create(0, width));
+    return true;
+  }
+  if (!resolveBuffer(state, arguments[0], op1, offset1) ||
+      !resolveBuffer(state, arguments[1], op2, offset2))
+    return false;
+
+  Scan scan;
+  ref<Expr> end;
+  if (!compareStrings(arguments, op1, offset1, op2, offset2, &n,
+                      width, scan, end))
+    return false;
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 ConstantExpr::create(0, width), scan.noStop, end);
+  return true;
+}
+
+bool SpecialFunctionHandler::modelMemcmp(ExecutionState &state,
+                                         KInstruction *target,
+                                         std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 3)
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  ObjectPair op1, op2;
+  uint64_t offset1, offset2, n;
+  if (!getConstantSize(executor, state, arguments[2], n))
+    return false;
+  if (n == 0) {
+    executor.bindLocal(target, state, ConstantExpr::create(0, width));
+    return true;
+  }
+  if (!resolveBuffer(state, arguments[0], op1, offset1) ||
+      !resolveBuffer(state, arguments[1], op2, offset2) ||
+      n > op1.first->size - offset1 || n > op2.first->size - offset2)
+    return false;
+
+  unsigned symbolic = 0;
+  Scan scan;
+  for (uint64_t i = 0; i < n && !scan.done; i++) {
+    ref<Expr> a = op1.second->read8(offset1 + i);
+    ref<Expr> b = op2.second->read8(offset2 + i);
+    if (tooManySymbolicBytes(a, symbolic) ||
+        tooManySymbolicBytes(b, symbolic))
+      return false;
+    scan.add(NeExpr::create(a, b), byteDifference(a, b, width));
+  }
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 ConstantExpr::create(0, width),
+                 ConstantExpr::create(0, Expr::Bool), arguments[0]);
+  return true;
+}
+
+// Applies an instruction of the exit condition of a scan function (see
+// LoopSummaryPass) to the value computed so far.
+static ref<Expr> applyScanInstruction(Instruction *i, ref<Expr> value,
+                                      Expr::Width width) {
+  ref<Expr> operand;
+  if (isa<BinaryOperator>(i))
+    operand = ConstantExpr::create(
+      cast<ConstantInt>(i->getOperand(1))->getZExtValue(), width);
+
+  switch (i->getOpcode()) {
+  case Instruction::ZExt: return ZExtExpr::create(value, width);
+  case Instruction::SExt: return SExtExpr::create(value, width);
+  case Instruction::Trunc: return ExtractExpr::create(value, 0, width);
+  case Instruction::Add: return AddExpr::create(value, operand);
+  case Instruction::Sub: return SubExpr::create(value, operand);
+  case Instruction::And: return AndExpr::create(value, operand);
+  case Instruction::Or: return OrExpr::create(value, operand);
+  case Instruction::Xor: return XorExpr::create(value, operand);
+  default: return ref<Expr>();
+  }
+}
+
+static ref<Expr> createComparison(CmpInst::Predicate predicate,
+                                  ref<Expr> left, ref<Expr> right) {
+  switch (predicate) {
+  case ICmpInst::ICMP_EQ: return EqExpr::create(left, right);
+  case ICmpInst::ICMP_NE: return NeExpr::create(left, right);
+  case ICmpInst::ICMP_UGT: return UgtExpr::create(left, right);
+  case ICmpInst::ICMP_UGE: return UgeExpr::create(left, right);
+  case ICmpInst::ICMP_ULT: return UltExpr::create(left, right);
+  case ICmpInst::ICMP_ULE: return UleExpr::create(left, right);
+  case ICmpInst::ICMP_SGT: return SgtExpr::create(left, right);
+  case ICmpInst::ICMP_SGE: return SgeExpr::create(left, right);
+  case ICmpInst::ICMP_SLT: return SltExpr::create(left, right);
+  case ICmpInst::ICMP_SLE: return SleExpr::create(left, right);
+  default: return ref<Expr>();
+  }
+}
+
+bool SpecialFunctionHandler::modelLoopScan(ExecutionState &state,
+                                           KInstruction *target,
+                                           std::vector<ref<Expr> > &arguments) {
+  if (arguments.size() != 1)
+    return false;
+
+  // the scan function has the form built by LoopSummaryPass: the loop loads
+  // a byte, computes the exit condition from it, and exits if it holds
+  CallSite cs(target->inst);
+  Function *f = cs.getCalledFunction();
+  if (!f || f->size() != 3)
+    return false;
+  BasicBlock *loop = ++f->begin();
+  BranchInst *br = dyn_cast<BranchInst>(loop->getTerminator());
+  if (!br || !br->isConditional())
+    return false;
+  bool exitOnTrue = br->getSuccessor(1) == loop;
+  ICmpInst *cmp = dyn_cast<ICmpInst>(br->getCondition());
+  if (!cmp || !isa<ConstantInt>(cmp->getOperand(1)))
+    return false;
+  std::vector<Instruction *> chain;
+  Instruction *i = dyn_cast<Instruction>(cmp->getOperand(0));
+  while (i && !isa<LoadInst>(i)) {
+    chain.insert(chain.begin(), i);
+    i = dyn_cast<Instruction>(i->getOperand(0));
+  }
+  if (!i)
+    return false;
+
+  ObjectPair op;
+  uint64_t offset;
+  if (!resolveBuffer(state, arguments[0], op, offset))
+    return false;
+
+  Expr::Width width = executor.getWidthForLLVMType(target->inst->getType());
+  ConstantInt *bound = cast<ConstantInt>(cmp->getOperand(1));
+  ref<Expr> right = ConstantExpr::create(bound->getZExtValue(),
+                                         bound->getBitWidth());
+  unsigned symbolic = 0;
+  Scan scan;
+  for (uint64_t n = offset; n < op.first->size && !scan.done; n++) {
+    ref<Expr> value = op.second->read8(n);
+    if (tooManySymbolicBytes(value, symbolic))
+      return false;
+    for (std::vector<Instruction *>::iterator ci = chain.begin();
+         ci != chain.end(); ++ci) {
+      value = applyScanInstruction(*ci, value,
+                                   executor.getWidthForLLVMType(
+                                     (*ci)->getType()));
+      if (value.isNull())
+        return false;
+    }
+    ref<Expr> condition = createComparison(cmp->getPredicate(), value, right);
+    if (condition.isNull())
+      return false;
+    if (!exitOnTrue)
+      condition = Expr::createIsZero(condition);
+    scan.add(condition, ConstantExpr::create(n - offset, width));
+  }
+
+  bindScanResult(state, target, scan.conditions, scan.values,
+                 ConstantExpr::create(0, width), scan.noStop, arguments[0]);
+  return true;
+}
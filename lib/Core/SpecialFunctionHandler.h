@@ -24,6 +24,8 @@ namespace klee {
   class Expr;
   class ExecutionState;
   struct KInstruction;
+  class MemoryObject;
+  class ObjectState;
   template<typename T> class ref;
   
   class SpecialFunctionHandler {
@@ -34,8 +36,16 @@ namespace klee {
                                                       &arguments);
     typedef std::map<const llvm::Function*, 
                      std::pair<Handler,bool> > handlers_ty;
+    /// A model returns false if it does not apply to the arguments, in
+    /// which case the function is executed.
+    typedef bool (SpecialFunctionHandler::*Model)(ExecutionState &state,
+                                                  KInstruction *target,
+                                                  std::vector<ref<Expr> >
+                                                    &arguments);
+    typedef std::map<const llvm::Function*, Model> models_ty;
 
     handlers_ty handlers;
+    models_ty models;
     class Executor &executor;
 
     struct HandlerInfo {
@@ -88,9 +98,35 @@ namespace klee {
                 KInstruction *target,
                 std::vector< ref<Expr> > &arguments);
 
+    /// Runs the native model of a library function (see
+    /// -native-string-functions). Returns false if there is no model for
+    /// the function or if it does not apply, in which case the function
+    /// must be executed.
+    bool handleModel(ExecutionState &state,
+                     llvm::Function *f,
+                     KInstruction *target,
+                     std::vector< ref<Expr> > &arguments);
+
     /* Convenience routines */
 
     std::string readStringAtAddress(ExecutionState &state, ref<Expr> address);
+
+    /// Resolves a concrete pointer to the object it points into. Returns
+    /// false if the pointer is symbolic or does not point into an object.
+    bool resolveBuffer(ExecutionState &state, ref<Expr> address,
+                       std::pair<const MemoryObject*,
+                                 const ObjectState*> &op,
+                       uint64_t &offset);
+
+    /// Binds the result of a scan: the value of the first position whose
+    /// condition holds, or \a tail if none does. \a noStop holds if the
+    /// scan reaches the end of the buffer at \a address, which is reported
+    /// as an out of bound access on a separate state.
+    void bindScanResult(ExecutionState &state, KInstruction *target,
+                        const std::vector< ref<Expr> > &conditions,
+                        const std::vector< ref<Expr> > &values,
+                        ref<Expr> tail, ref<Expr> noStop,
+                        ref<Expr> address);
     
     /* Handlers */
 
@@ -138,6 +174,20 @@ namespace klee {
     HANDLER(handleSubOverflow);
     HANDLER(handleDivRemOverflow);
 #undef HANDLER
+
+    /* Models */
+
+#define MODEL(name) bool name(ExecutionState &state, \
+                              KInstruction *target, \
+                              std::vector< ref<Expr> > &arguments)
+    MODEL(modelLoopScan);
+    MODEL(modelMemchr);
+    MODEL(modelMemcmp);
+    MODEL(modelStrchr);
+    MODEL(modelStrcmp);
+    MODEL(modelStrlen);
+    MODEL(modelStrncmp);
+#undef MODEL
   };
 } // End klee namespace
 
@@ -0,0 +1,69 @@
+//===-- StatsService.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "StatsService.h"
+
+#include <signal.h>
+
+using namespace klee;
+
+StatsService::StatsService() : running(false), stopped(false) {
+  /* the executor timers must be delivered to the interpreter thread */
+  sigset_t blocked, old;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGALRM);
+  sigaddset(&blocked, SIGINT);
+  pthread_sigmask(SIG_BLOCK, &blocked, &old);
+  worker = std::thread(&StatsService::run, this);
+  pthread_sigmask(SIG_SETMASK, &old, 0);
+}
+
+StatsService::~StatsService() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopped = true;
+  }
+  posted.notify_one();
+  worker.join();
+}
+
+void StatsService::post(const Job &job) {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    jobs.push_back(job);
+  }
+  posted.notify_one();
+}
+
+void StatsService::wait() {
+  std::unique_lock<std::mutex> guard(lock);
+  while (running || !jobs.empty())
+    idle.wait(guard);
+}
+
+void StatsService::run() {
+  std::unique_lock<std::mutex> guard(lock);
+  for (;;) {
+    while (jobs.empty() && !stopped)
+      posted.wait(guard);
+    /* the pending jobs are run before stopping */
+    if (jobs.empty())
+      break;
+
+    Job job = jobs.front();
+    jobs.pop_front();
+    running = true;
+    guard.unlock();
+    job();
+    guard.lock();
+    running = false;
+    if (jobs.empty())
+      idle.notify_all();
+  }
+}
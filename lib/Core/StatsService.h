@@ -0,0 +1,56 @@
+//===-- StatsService.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STATSSERVICE_H
+#define KLEE_STATSSERVICE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace klee {
+  /// StatsService - Runs the periodic statistics work (writing the stats
+  /// files, computing the distances to the uncovered instructions) on a
+  /// separate thread, so that the interpreter does not stall at each timer
+  /// tick. The jobs are run in the order they were posted. Besides the data
+  /// captured for them by the interpreter thread, they read the module, so
+  /// the interpreter thread waits for them before it changes the module.
+  class StatsService {
+  public:
+    typedef std::function<void()> Job;
+
+  private:
+    std::thread worker;
+    std::mutex lock;
+    /// Signalled when a job is posted, or the service is stopped.
+    std::condition_variable posted;
+    /// Signalled when the queue becomes empty and no job is running.
+    std::condition_variable idle;
+    std::deque<Job> jobs;
+    bool running;
+    bool stopped;
+
+    void run();
+
+  public:
+    StatsService();
+    /// Runs the pending jobs and stops the thread.
+    ~StatsService();
+
+    /// Queues a job, without waiting for it.
+    void post(const Job &job);
+
+    /// Waits until all the posted jobs were run.
+    void wait();
+  };
+}
+
+#endif
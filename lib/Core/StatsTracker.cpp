@@ -16,7 +16,9 @@
 #include "klee/Internal/Module/KModule.h"
 #include "klee/Internal/Module/KInstruction.h"
 #include "klee/Internal/Support/ModuleUtil.h"
+#include "klee/Internal/Support/PhaseTrace.h"
 #include "klee/Internal/System/MemoryUsage.h"
+#include "klee/Internal/System/PerfCounters.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 #include "klee/SolverStats.h"
@@ -25,6 +27,7 @@
 #include "CoreStats.h"
 #include "Executor.h"
 #include "MemoryManager.h"
+#include "StatsService.h"
 #include "UserSearcher.h"
 
 #if LLVM_VERSION_CODE > LLVM_VERSION(3, 2)
@@ -47,6 +50,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
 
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
@@ -58,6 +62,7 @@
 #endif
 
 #include <fstream>
+#include <memory>
 #include <unistd.h>
 
 using namespace klee;
@@ -107,6 +112,11 @@ namespace {
                           cl::init(30.),
 			  cl::desc("(default=30.0s)"));
   
+  cl::opt<bool>
+  StatsThread("stats-thread",
+              cl::init(false),
+              cl::desc("Write the statistics files and update the distances to the uncovered instructions on a separate thread (default=off)"));
+
   cl::opt<bool>
   UseCallPaths("use-call-paths",
 	       cl::init(true),
@@ -147,9 +157,47 @@ namespace klee {
   public:
     UpdateReachableTimer(StatsTracker *_statsTracker) : statsTracker(_statsTracker) {}
     
-    void run() { statsTracker->computeReachableUncovered(); }
+    void run() { statsTracker->updateReachableUncovered(); }
+  };
+
+  /// The per-instruction values written to run.istats, captured by the
+  /// interpreter thread.
+  struct IStatsSnapshot {
+    /// The ids of the statistics which are written, in increasing order.
+    std::vector<unsigned> statistics;
+    /// The values of these statistics, statistics.size() per instruction.
+    std::vector<uint64_t> values;
+    CallSiteSummaryTable callSiteStats;
+  };
+
+  class WriteStatsLineJob {
+    llvm::raw_fd_ostream *file;
+    std::string line;
+
+  public:
+    WriteStatsLineJob(llvm::raw_fd_ostream *_file, const std::string &_line)
+      : file(_file), line(_line) {}
+
+    void operator()() {
+      *file << line;
+      file->flush();
+    }
+  };
+
+  class WriteIStatsJob {
+    StatsTracker *statsTracker;
+    std::shared_ptr<IStatsSnapshot> snapshot;
+
+  public:
+    WriteIStatsJob(StatsTracker *_statsTracker,
+                   const std::shared_ptr<IStatsSnapshot> &_snapshot)
+      : statsTracker(_statsTracker), snapshot(_snapshot) {}
+
+    void operator()() {
+      statsTracker->writeIStats(*snapshot);
+      statsTracker->istatsPending = false;
+    }
   };
- 
 }
 
 //
@@ -178,7 +226,8 @@ static bool instructionIsCoverable(Instruction *i) {
 }
 
 StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
-                           bool _updateMinDistToUncovered)
+                           bool _updateMinDistToUncovered,
+                           bool _perfCounters)
   : executor(_executor),
     objectFilename(_objectFilename),
     statsFile(0),
@@ -187,7 +236,10 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     numBranches(0),
     fullBranches(0),
     partialBranches(0),
-    updateMinDistToUncovered(_updateMinDistToUncovered) {
+    updateMinDistToUncovered(_updateMinDistToUncovered),
+    perfCounters(_perfCounters),
+    service(0),
+    istatsPending(false) {
 
   if (StatsWriteAfterInstructions > 0 && StatsWriteInterval > 0)
     klee_error("Both options --stats-write-interval and "
@@ -267,9 +319,13 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     if (IStatsWriteInterval > 0)
       executor.addTimer(new WriteIStatsTimer(this), IStatsWriteInterval);
   }
+
+  if (StatsThread && (statsFile || istatsFile || updateMinDistToUncovered))
+    service = new StatsService();
 }
 
 StatsTracker::~StatsTracker() {  
+  delete service;
   if (statsFile)
     delete statsFile;
   if (istatsFile)
@@ -277,6 +333,14 @@ StatsTracker::~StatsTracker() {
 }
 
 void StatsTracker::done() {
+  /* the final writes are done by the interpreter thread */
+  if (service) {
+    delete service;
+    service = 0;
+    if (reachable.valid())
+      installReachable(reachable.get());
+  }
+
   if (statsFile)
     writeStatsLine();
 
@@ -287,6 +351,26 @@ void StatsTracker::done() {
   }
 }
 
+void StatsTracker::checkpoint() {
+  /* an istats job which is still queued would skip this write */
+  if (service)
+    service->wait();
+
+  if (statsFile)
+    writeStatsLine();
+
+  if (istatsFile)
+    writeIStats();
+
+  if (service)
+    service->wait();
+}
+
+void StatsTracker::waitForService() {
+  if (service)
+    service->wait();
+}
+
 void StatsTracker::stepInstruction(ExecutionState &es) {
   if (OutputIStats) {
     if (TrackInstructionTime) {
@@ -419,11 +503,21 @@ void StatsTracker::writeStatsHeader() {
              << "'SolverTime',"
              << "'CexCacheTime',"
              << "'ForkTime',"
-             << "'ResolveTime',"
+             << "'ResolveTime',";
+  if (perfCounters) {
+    for (unsigned phase = 0; phase < perf::NumPhases; phase++) {
+      for (unsigned counter = 0; counter < perf::NumCounters; counter++) {
+        *statsFile << "'Perf"
+                   << perf::getPhaseName((perf::Phase)phase)
+                   << perf::getCounterName((perf::Counter)counter) << "',";
+      }
+    }
+  }
+  *statsFile << "'NumQueryLookupTables',";
 #ifdef DEBUG
-	     << "'ArrayHashTime',"
+  *statsFile << "'ArrayHashTime',";
 #endif
-             << ")\n";
+  *statsFile << ")\n";
   statsFile->flush();
 }
 
@@ -432,29 +526,52 @@ double StatsTracker::elapsed() {
 }
 
 void StatsTracker::writeStatsLine() {
-  *statsFile << "(" << stats::instructions
-             << "," << fullBranches
-             << "," << partialBranches
-             << "," << numBranches
-             << "," << util::getUserTime()
-             << "," << executor.states.size()
-             << "," << util::GetTotalMallocUsage() + executor.memory->getUsedDeterministicSize()
-             << "," << stats::queries
-             << "," << stats::queryConstructs
-             << "," << 0 // was numObjects
-             << "," << elapsed()
-             << "," << stats::coveredInstructions
-             << "," << stats::uncoveredInstructions
-             << "," << stats::queryTime / 1000000.
-             << "," << stats::solverTime / 1000000.
-             << "," << stats::cexCacheTime / 1000000.
-             << "," << stats::forkTime / 1000000.
-             << "," << stats::resolveTime / 1000000.
+  trace::PhaseScope tracePhase(trace::Stats);
+  std::string line;
+  llvm::raw_string_ostream os(line);
+  os << "(" << stats::instructions
+     << "," << fullBranches
+     << "," << partialBranches
+     << "," << numBranches
+     << "," << util::getUserTime()
+     << "," << executor.states.size()
+     << "," << util::GetTotalMallocUsage() + executor.memory->getUsedDeterministicSize()
+     << "," << stats::queries
+     << "," << stats::queryConstructs
+     << "," << 0 // was numObjects
+     << "," << elapsed()
+     << "," << stats::coveredInstructions
+     << "," << stats::uncoveredInstructions
+     << "," << stats::queryTime / 1000000.
+     << "," << stats::solverTime / 1000000.
+     << "," << stats::cexCacheTime / 1000000.
+     << "," << stats::forkTime / 1000000.
+     << "," << stats::resolveTime / 1000000.;
+
+  /* zero if the counters could not be opened */
+  if (perfCounters) {
+    if (perf::enabled)
+      perf::update();
+    for (unsigned phase = 0; phase < perf::NumPhases; phase++) {
+      for (unsigned counter = 0; counter < perf::NumCounters; counter++) {
+        os << "," << perf::getValue((perf::Phase)phase,
+                                    (perf::Counter)counter);
+      }
+    }
+  }
+  os << "," << stats::queryLookupTables;
 #ifdef DEBUG
-             //<< "," << stats::arrayHashTime / 1000000.
+  //os << "," << stats::arrayHashTime / 1000000.;
 #endif
-             << ")\n";
-  statsFile->flush();
+  os << ")\n";
+  os.flush();
+
+  if (service) {
+    service->post(WriteStatsLineJob(statsFile, line));
+  } else {
+    *statsFile << line;
+    statsFile->flush();
+  }
 }
 
 void StatsTracker::updateStateStatistics(uint64_t addend) {
@@ -469,21 +586,13 @@ void StatsTracker::updateStateStatistics(uint64_t addend) {
 }
 
 void StatsTracker::writeIStats() {
-  Module *m = executor.kmodule->module;
-  uint64_t istatsMask = 0;
-  llvm::raw_fd_ostream &of = *istatsFile;
-  
-  // We assume that we didn't move the file pointer
-  unsigned istatsSize = of.tell();
+  trace::PhaseScope tracePhase(trace::Stats);
 
-  of.seek(0);
+  /* the previous snapshot is still being written */
+  if (istatsPending)
+    return;
 
-  of << "version: 1\n";
-  of << "creator: klee\n";
-  of << "pid: " << getpid() << "\n";
-  of << "cmd: " << m->getModuleIdentifier() << "\n\n";
-  of << "\n";
-  
+  uint64_t istatsMask = 0;
   StatisticManager &sm = *theStatisticManager;
   unsigned nStats = sm.getNumStatistics();
 
@@ -502,33 +611,74 @@ void StatsTracker::writeIStats() {
   istatsMask |= 1<<sm.getStatisticID("States");
   istatsMask |= 1<<sm.getStatisticID("MinDistToUncovered");
 
+  /* the file is written from a copy of the values, so that it can be
+     written by the service thread while the interpreter runs */
+  std::shared_ptr<IStatsSnapshot> snapshot(new IStatsSnapshot());
+  for (unsigned i=0; i<nStats; i++)
+    if (istatsMask & (1<<i))
+      snapshot->statistics.push_back(i);
+
+  // set state counts, decremented after we process so that we don't
+  // have to zero all records each time.
+  if (istatsMask & (1<<stats::states.getID()))
+    updateStateStatistics(1);
+
+  unsigned numIndices = executor.kmodule->infos->getMaxID();
+  unsigned numValues = snapshot->statistics.size();
+  snapshot->values.resize(numIndices * numValues);
+  for (unsigned index=0; index<numIndices; index++)
+    for (unsigned i=0; i<numValues; i++)
+      snapshot->values[index * numValues + i] =
+        sm.getIndexedValue(sm.getStatistic(snapshot->statistics[i]), index);
+
+  if (UseCallPaths)
+    callPathManager.getSummaryStatistics(snapshot->callSiteStats);
+
+  if (istatsMask & (1<<stats::states.getID()))
+    updateStateStatistics((uint64_t)-1);
+
+  if (service) {
+    istatsPending = true;
+    service->post(WriteIStatsJob(this, snapshot));
+  } else {
+    writeIStats(*snapshot);
+  }
+}
+
+void StatsTracker::writeIStats(const IStatsSnapshot &snapshot) {
+  Module *m = executor.kmodule->module;
+  llvm::raw_fd_ostream &of = *istatsFile;
+  
+  // We assume that we didn't move the file pointer
+  unsigned istatsSize = of.tell();
+
+  of.seek(0);
+
+  of << "version: 1\n";
+  of << "creator: klee\n";
+  of << "pid: " << getpid() << "\n";
+  of << "cmd: " << m->getModuleIdentifier() << "\n\n";
+  of << "\n";
+  
+  StatisticManager &sm = *theStatisticManager;
+  unsigned numValues = snapshot.statistics.size();
+
   of << "positions: instr line\n";
 
-  for (unsigned i=0; i<nStats; i++) {
-    if (istatsMask & (1<<i)) {
-      Statistic &s = sm.getStatistic(i);
-      of << "event: " << s.getShortName() << " : " 
-         << s.getName() << "\n";
-    }
+  for (unsigned i=0; i<numValues; i++) {
+    Statistic &s = sm.getStatistic(snapshot.statistics[i]);
+    of << "event: " << s.getShortName() << " : " 
+       << s.getName() << "\n";
   }
 
   of << "events: ";
-  for (unsigned i=0; i<nStats; i++) {
-    if (istatsMask & (1<<i))
-      of << sm.getStatistic(i).getShortName() << " ";
-  }
+  for (unsigned i=0; i<numValues; i++)
+    of << sm.getStatistic(snapshot.statistics[i]).getShortName() << " ";
   of << "\n";
-  
-  // set state counts, decremented after we process so that we don't
-  // have to zero all records each time.
-  if (istatsMask & (1<<stats::states.getID()))
-    updateStateStatistics(1);
 
   std::string sourceFile = "";
 
-  CallSiteSummaryTable callSiteStats;
-  if (UseCallPaths)
-    callPathManager.getSummaryStatistics(callSiteStats);
+  const CallSiteSummaryTable &callSiteStats = snapshot.callSiteStats;
 
   of << "ob=" << objectFilename << "\n";
 
@@ -558,20 +708,19 @@ void StatsTracker::writeIStats() {
           }
           of << ii.assemblyLine << " ";
           of << ii.line << " ";
-          for (unsigned i=0; i<nStats; i++)
-            if (istatsMask&(1<<i))
-              of << sm.getIndexedValue(sm.getStatistic(i), index) << " ";
+          for (unsigned i=0; i<numValues; i++)
+            of << snapshot.values[index * numValues + i] << " ";
           of << "\n";
 
           if (UseCallPaths && 
               (isa<CallInst>(instr) || isa<InvokeInst>(instr))) {
-            CallSiteSummaryTable::iterator it = callSiteStats.find(instr);
+            CallSiteSummaryTable::const_iterator it = callSiteStats.find(instr);
             if (it!=callSiteStats.end()) {
-              for (std::map<llvm::Function*, CallSiteInfo>::iterator
+              for (std::map<llvm::Function*, CallSiteInfo>::const_iterator
                      fit = it->second.begin(), fie = it->second.end(); 
                    fit != fie; ++fit) {
                 Function *f = fit->first;
-                CallSiteInfo &csi = fit->second;
+                const CallSiteInfo &csi = fit->second;
                 const InstructionInfo &fii = 
                   executor.kmodule->infos->getFunctionInfo(f);
   
@@ -584,21 +733,19 @@ void StatsTracker::writeIStats() {
 
                 of << ii.assemblyLine << " ";
                 of << ii.line << " ";
-                for (unsigned i=0; i<nStats; i++) {
-                  if (istatsMask&(1<<i)) {
-                    Statistic &s = sm.getStatistic(i);
-                    uint64_t value;
-
-                    // Hack, ignore things that don't make sense on
-                    // call paths.
-                    if (&s == &stats::uncoveredInstructions) {
-                      value = 0;
-                    } else {
-                      value = csi.statistics.getValue(s);
-                    }
-
-                    of << value << " ";
+                for (unsigned i=0; i<numValues; i++) {
+                  Statistic &s = sm.getStatistic(snapshot.statistics[i]);
+                  uint64_t value;
+
+                  // Hack, ignore things that don't make sense on
+                  // call paths.
+                  if (&s == &stats::uncoveredInstructions) {
+                    value = 0;
+                  } else {
+                    value = csi.statistics.getValue(s);
                   }
+
+                  of << value << " ";
                 }
                 of << "\n";
               }
@@ -609,9 +756,6 @@ void StatsTracker::writeIStats() {
     }
   }
 
-  if (istatsMask & (1<<stats::states.getID()))
-    updateStateStatistics((uint64_t)-1);
-  
   // Clear then end of the file if necessary (no truncate op?).
   unsigned pos = of.tell();
   for (unsigned i=pos; i<istatsSize; ++i)
@@ -664,180 +808,181 @@ uint64_t klee::computeMinDistToUncovered(const KInstruction *ki,
   }
 }
 
-void StatsTracker::computeReachableUncovered() {
-  KModule *km = executor.kmodule;
+/* the instructions of the module in reverse order, in which the distances
+   converge faster */
+static std::vector<Instruction*> reachableOrder;
+
+static void initializeReachable(KModule *km) {
   Module *m = km->module;
   static bool init = true;
   const InstructionInfoTable &infos = *km->infos;
   StatisticManager &sm = *theStatisticManager;
-  
-  if (init) {
-    init = false;
-
-    // Compute call targets. It would be nice to use alias information
-    // instead of assuming all indirect calls hit all escaping
-    // functions, eh?
-    for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
-         fnIt != fn_ie; ++fnIt) {
-      for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
-           bbIt != bb_ie; ++bbIt) {
-        for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
-             it != ie; ++it) {
-          if (isa<CallInst>(it) || isa<InvokeInst>(it)) {
-            CallSite cs(it);
-            if (isa<InlineAsm>(cs.getCalledValue())) {
-              // We can never call through here so assume no targets
-              // (which should be correct anyhow).
-              callTargets.insert(std::make_pair(it,
-                                                std::vector<Function*>()));
-            } else if (Function *target = getDirectCallTarget(cs)) {
-              callTargets[it].push_back(target);
-            } else {
-              callTargets[it] = 
-                std::vector<Function*>(km->escapingFunctions.begin(),
-                                       km->escapingFunctions.end());
-            }
+
+  if (!init)
+    return;
+  init = false;
+
+  // Compute call targets. It would be nice to use alias information
+  // instead of assuming all indirect calls hit all escaping
+  // functions, eh?
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
+       fnIt != fn_ie; ++fnIt) {
+    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
+         bbIt != bb_ie; ++bbIt) {
+      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
+           it != ie; ++it) {
+        if (isa<CallInst>(it) || isa<InvokeInst>(it)) {
+          CallSite cs(it);
+          if (isa<InlineAsm>(cs.getCalledValue())) {
+            // We can never call through here so assume no targets
+            // (which should be correct anyhow).
+            callTargets.insert(std::make_pair(it,
+                                              std::vector<Function*>()));
+          } else if (Function *target = getDirectCallTarget(cs)) {
+            callTargets[it].push_back(target);
+          } else {
+            callTargets[it] = 
+              std::vector<Function*>(km->escapingFunctions.begin(),
+                                     km->escapingFunctions.end());
           }
         }
       }
     }
+  }
 
-    // Compute function callers as reflexion of callTargets.
-    for (calltargets_ty::iterator it = callTargets.begin(), 
-           ie = callTargets.end(); it != ie; ++it)
-      for (std::vector<Function*>::iterator fit = it->second.begin(), 
-             fie = it->second.end(); fit != fie; ++fit) 
-        functionCallers[*fit].push_back(it->first);
-
-    // Initialize minDistToReturn to shortest paths through
-    // functions. 0 is unreachable.
-    std::vector<Instruction *> instructions;
-    for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
-         fnIt != fn_ie; ++fnIt) {
-      if (fnIt->isDeclaration()) {
-        if (fnIt->doesNotReturn()) {
-          functionShortestPath[fnIt] = 0;
-        } else {
-          functionShortestPath[fnIt] = 1; // whatever
-        }
-      } else {
+  // Compute function callers as reflexion of callTargets.
+  for (calltargets_ty::iterator it = callTargets.begin(), 
+         ie = callTargets.end(); it != ie; ++it)
+    for (std::vector<Function*>::iterator fit = it->second.begin(), 
+           fie = it->second.end(); fit != fie; ++fit) 
+      functionCallers[*fit].push_back(it->first);
+
+  // Initialize minDistToReturn to shortest paths through
+  // functions. 0 is unreachable.
+  std::vector<Instruction *> instructions;
+  for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
+       fnIt != fn_ie; ++fnIt) {
+    if (fnIt->isDeclaration()) {
+      if (fnIt->doesNotReturn()) {
         functionShortestPath[fnIt] = 0;
+      } else {
+        functionShortestPath[fnIt] = 1; // whatever
       }
+    } else {
+      functionShortestPath[fnIt] = 0;
+    }
 
-      // Not sure if I should bother to preorder here. XXX I should.
-      for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
-           bbIt != bb_ie; ++bbIt) {
-        for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
-             it != ie; ++it) {
-          instructions.push_back(it);
-          unsigned id = infos.getInfo(it).id;
-          sm.setIndexedValue(stats::minDistToReturn, 
-                             id, 
-                             isa<ReturnInst>(it)
+    // Not sure if I should bother to preorder here. XXX I should.
+    for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
+         bbIt != bb_ie; ++bbIt) {
+      for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
+           it != ie; ++it) {
+        instructions.push_back(it);
+        unsigned id = infos.getInfo(it).id;
+        sm.setIndexedValue(stats::minDistToReturn, 
+                           id, 
+                           isa<ReturnInst>(it)
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 1)
-                             || isa<UnwindInst>(it)
+                           || isa<UnwindInst>(it)
 #endif
-                             );
-        }
+                           );
       }
     }
+  }
+
+  std::reverse(instructions.begin(), instructions.end());
   
-    std::reverse(instructions.begin(), instructions.end());
-    
-    // I'm so lazy it's not even worklisted.
-    bool changed;
-    do {
-      changed = false;
-      for (std::vector<Instruction*>::iterator it = instructions.begin(),
-             ie = instructions.end(); it != ie; ++it) {
-        Instruction *inst = *it;
-        unsigned bestThrough = 0;
-
-        if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
-          std::vector<Function*> &targets = callTargets[inst];
-          for (std::vector<Function*>::iterator fnIt = targets.begin(),
-                 ie = targets.end(); fnIt != ie; ++fnIt) {
-            uint64_t dist = functionShortestPath[*fnIt];
-            if (dist) {
-              dist = 1+dist; // count instruction itself
-              if (bestThrough==0 || dist<bestThrough)
-                bestThrough = dist;
-            }
+  // I'm so lazy it's not even worklisted.
+  bool changed;
+  do {
+    changed = false;
+    for (std::vector<Instruction*>::iterator it = instructions.begin(),
+           ie = instructions.end(); it != ie; ++it) {
+      Instruction *inst = *it;
+      unsigned bestThrough = 0;
+
+      if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
+        std::vector<Function*> &targets = callTargets[inst];
+        for (std::vector<Function*>::iterator fnIt = targets.begin(),
+               ie = targets.end(); fnIt != ie; ++fnIt) {
+          uint64_t dist = functionShortestPath[*fnIt];
+          if (dist) {
+            dist = 1+dist; // count instruction itself
+            if (bestThrough==0 || dist<bestThrough)
+              bestThrough = dist;
           }
-        } else {
-          bestThrough = 1;
         }
-       
-        if (bestThrough) {
-          unsigned id = infos.getInfo(*it).id;
-          uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToReturn, id);
-          std::vector<Instruction*> succs = getSuccs(*it);
-          for (std::vector<Instruction*>::iterator it2 = succs.begin(),
-                 ie = succs.end(); it2 != ie; ++it2) {
-            uint64_t dist = sm.getIndexedValue(stats::minDistToReturn,
-                                               infos.getInfo(*it2).id);
-            if (dist) {
-              uint64_t val = bestThrough + dist;
-              if (best==0 || val<best)
-                best = val;
-            }
-          }
-          // there's a corner case here when a function only includes a single
-          // instruction (a ret). in that case, we MUST update
-          // functionShortestPath, or it will remain 0 (erroneously indicating
-          // that no return instructions are reachable)
-          Function *f = inst->getParent()->getParent();
-          if (best != cur
-              || (inst == f->begin()->begin()
-                  && functionShortestPath[f] != best)) {
-            sm.setIndexedValue(stats::minDistToReturn, id, best);
-            changed = true;
-
-            // Update shortest path if this is the entry point.
-            if (inst==f->begin()->begin())
-              functionShortestPath[f] = best;
+      } else {
+        bestThrough = 1;
+      }
+     
+      if (bestThrough) {
+        unsigned id = infos.getInfo(*it).id;
+        uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToReturn, id);
+        std::vector<Instruction*> succs = getSuccs(*it);
+        for (std::vector<Instruction*>::iterator it2 = succs.begin(),
+               ie = succs.end(); it2 != ie; ++it2) {
+          uint64_t dist = sm.getIndexedValue(stats::minDistToReturn,
+                                             infos.getInfo(*it2).id);
+          if (dist) {
+            uint64_t val = bestThrough + dist;
+            if (best==0 || val<best)
+              best = val;
           }
         }
+        // there's a corner case here when a function only includes a single
+        // instruction (a ret). in that case, we MUST update
+        // functionShortestPath, or it will remain 0 (erroneously indicating
+        // that no return instructions are reachable)
+        Function *f = inst->getParent()->getParent();
+        if (best != cur
+            || (inst == f->begin()->begin()
+                && functionShortestPath[f] != best)) {
+          sm.setIndexedValue(stats::minDistToReturn, id, best);
+          changed = true;
+
+          // Update shortest path if this is the entry point.
+          if (inst==f->begin()->begin())
+            functionShortestPath[f] = best;
+        }
       }
-    } while (changed);
-  }
+    }
+  } while (changed);
 
-  // compute minDistToUncovered, 0 is unreachable
-  std::vector<Instruction *> instructions;
   for (Module::iterator fnIt = m->begin(), fn_ie = m->end(); 
        fnIt != fn_ie; ++fnIt) {
-    // Not sure if I should bother to preorder here.
     for (Function::iterator bbIt = fnIt->begin(), bb_ie = fnIt->end(); 
          bbIt != bb_ie; ++bbIt) {
       for (BasicBlock::iterator it = bbIt->begin(), ie = bbIt->end(); 
-           it != ie; ++it) {
-        unsigned id = infos.getInfo(it).id;
-        instructions.push_back(&*it);
-        sm.setIndexedValue(stats::minDistToUncovered, 
-                           id, 
-                           sm.getIndexedValue(stats::uncoveredInstructions, id));
-      }
+           it != ie; ++it)
+        reachableOrder.push_back(&*it);
     }
   }
-  
-  std::reverse(instructions.begin(), instructions.end());
-  
+  std::reverse(reachableOrder.begin(), reachableOrder.end());
+}
+
+/// Computes minDistToUncovered, 0 is unreachable. distances holds the
+/// values per instruction id, and is initialized with the uncovered
+/// instructions. Only reads the tables built by initializeReachable, so
+/// that it can be run by the service thread.
+static void computeMinDistances(const InstructionInfoTable &infos,
+                                std::vector<uint64_t> &distances) {
   // I'm so lazy it's not even worklisted.
   bool changed;
   do {
     changed = false;
-    for (std::vector<Instruction*>::iterator it = instructions.begin(),
-           ie = instructions.end(); it != ie; ++it) {
+    for (std::vector<Instruction*>::iterator it = reachableOrder.begin(),
+           ie = reachableOrder.end(); it != ie; ++it) {
       Instruction *inst = *it;
-      uint64_t best, cur = best = sm.getIndexedValue(stats::minDistToUncovered, 
-                                                     infos.getInfo(inst).id);
+      unsigned id = infos.getInfo(inst).id;
+      uint64_t best, cur = best = distances[id];
       unsigned bestThrough = 0;
       
       if (isa<CallInst>(inst) || isa<InvokeInst>(inst)) {
-        std::vector<Function*> &targets = callTargets[inst];
-        for (std::vector<Function*>::iterator fnIt = targets.begin(),
+        const std::vector<Function*> &targets = callTargets.find(inst)->second;
+        for (std::vector<Function*>::const_iterator fnIt = targets.begin(),
                ie = targets.end(); fnIt != ie; ++fnIt) {
-          uint64_t dist = functionShortestPath[*fnIt];
+          uint64_t dist = functionShortestPath.find(*fnIt)->second;
           if (dist) {
             dist = 1+dist; // count instruction itself
             if (bestThrough==0 || dist<bestThrough)
@@ -845,8 +990,7 @@ void StatsTracker::computeReachableUncovered() {
           }
 
           if (!(*fnIt)->isDeclaration()) {
-            uint64_t calleeDist = sm.getIndexedValue(stats::minDistToUncovered,
-                                                     infos.getFunctionInfo(*fnIt).id);
+            uint64_t calleeDist = distances[infos.getFunctionInfo(*fnIt).id];
             if (calleeDist) {
               calleeDist = 1+calleeDist; // count instruction itself
               if (best==0 || calleeDist<best)
@@ -862,8 +1006,7 @@ void StatsTracker::computeReachableUncovered() {
         std::vector<Instruction*> succs = getSuccs(inst);
         for (std::vector<Instruction*>::iterator it2 = succs.begin(),
                ie = succs.end(); it2 != ie; ++it2) {
-          uint64_t dist = sm.getIndexedValue(stats::minDistToUncovered,
-                                             infos.getInfo(*it2).id);
+          uint64_t dist = distances[infos.getInfo(*it2).id];
           if (dist) {
             uint64_t val = bestThrough + dist;
             if (best==0 || val<best)
@@ -873,13 +1016,54 @@ void StatsTracker::computeReachableUncovered() {
       }
 
       if (best != cur) {
-        sm.setIndexedValue(stats::minDistToUncovered, 
-                           infos.getInfo(inst).id, 
-                           best);
+        distances[id] = best;
         changed = true;
       }
     }
   } while (changed);
+}
+
+namespace klee {
+  class ReachableJob {
+    const InstructionInfoTable *infos;
+    std::shared_ptr<std::vector<uint64_t> > distances;
+    std::shared_ptr<std::promise<std::vector<uint64_t> > > result;
+
+  public:
+    ReachableJob(const InstructionInfoTable *_infos,
+                 const std::shared_ptr<std::vector<uint64_t> > &_distances,
+                 const std::shared_ptr<std::promise<std::vector<uint64_t> > > &_result)
+      : infos(_infos), distances(_distances), result(_result) {}
+
+    void operator()() {
+      computeMinDistances(*infos, *distances);
+      result->set_value(*distances);
+    }
+  };
+}
+
+void StatsTracker::captureReachable(std::vector<uint64_t> &distances) {
+  KModule *km = executor.kmodule;
+  const InstructionInfoTable &infos = *km->infos;
+  StatisticManager &sm = *theStatisticManager;
+
+  initializeReachable(km);
+
+  unsigned numIndices = infos.getMaxID();
+  distances.resize(numIndices);
+  for (unsigned id=0; id<numIndices; id++)
+    distances[id] = sm.getIndexedValue(stats::minDistToUncovered, id);
+  for (std::vector<Instruction*>::iterator it = reachableOrder.begin(),
+         ie = reachableOrder.end(); it != ie; ++it) {
+    unsigned id = infos.getInfo(*it).id;
+    distances[id] = sm.getIndexedValue(stats::uncoveredInstructions, id);
+  }
+}
+
+void StatsTracker::installReachable(const std::vector<uint64_t> &distances) {
+  StatisticManager &sm = *theStatisticManager;
+  for (unsigned id=0; id<distances.size(); id++)
+    sm.setIndexedValue(stats::minDistToUncovered, id, distances[id]);
 
   for (std::set<ExecutionState*>::iterator it = executor.states.begin(),
          ie = executor.states.end(); it != ie; ++it) {
@@ -903,3 +1087,35 @@ void StatsTracker::computeReachableUncovered() {
     }
   }
 }
+
+void StatsTracker::computeReachableUncovered() {
+  trace::PhaseScope tracePhase(trace::Stats);
+  std::vector<uint64_t> distances;
+  captureReachable(distances);
+  computeMinDistances(*executor.kmodule->infos, distances);
+  installReachable(distances);
+}
+
+/* with the service thread, the distances which were computed since the
+   previous tick are installed (they do not account for the instructions
+   covered in the meantime), and the next computation is started */
+void StatsTracker::updateReachableUncovered() {
+  if (!service) {
+    computeReachableUncovered();
+    return;
+  }
+
+  trace::PhaseScope tracePhase(trace::Stats);
+  if (reachable.valid()) {
+    if (reachable.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return;
+    installReachable(reachable.get());
+  }
+
+  std::shared_ptr<std::vector<uint64_t> > distances(new std::vector<uint64_t>());
+  captureReachable(*distances);
+  std::shared_ptr<std::promise<std::vector<uint64_t> > > result(
+      new std::promise<std::vector<uint64_t> >());
+  reachable = result->get_future();
+  service->post(ReachableJob(executor.kmodule->infos, distances, result));
+}
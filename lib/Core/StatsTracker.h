@@ -12,7 +12,10 @@
 
 #include "CallPathManager.h"
 
+#include <atomic>
+#include <future>
 #include <set>
+#include <vector>
 
 namespace llvm {
   class BranchInst;
@@ -29,9 +32,14 @@ namespace klee {
   struct KInstruction;
   struct StackFrame;
 
+  class StatsService;
+  struct IStatsSnapshot;
+
   class StatsTracker {
     friend class WriteStatsTimer;
     friend class WriteIStatsTimer;
+    friend class UpdateReachableTimer;
+    friend class WriteIStatsJob;
 
     Executor &executor;
     std::string objectFilename;
@@ -46,6 +54,18 @@ namespace klee {
 
     bool updateMinDistToUncovered;
 
+    /// Whether run.stats has the hardware counter columns (-perf-counters).
+    bool perfCounters;
+
+    /// Writes the stats files and computes the distances to the
+    /// uncovered instructions in the background (-stats-thread), or null.
+    StatsService *service;
+    /// Set while an istats job is queued or being written.
+    std::atomic<bool> istatsPending;
+    /// The distances to the uncovered instructions which are computed by
+    /// the service thread, indexed by instruction id.
+    std::future<std::vector<uint64_t> > reachable;
+
   public:
     static bool useStatistics();
 
@@ -54,10 +74,15 @@ namespace klee {
     void writeStatsHeader();
     void writeStatsLine();
     void writeIStats();
+    void writeIStats(const IStatsSnapshot &snapshot);
+
+    void captureReachable(std::vector<uint64_t> &distances);
+    void installReachable(const std::vector<uint64_t> &distances);
+    void updateReachableUncovered();
 
   public:
     StatsTracker(Executor &_executor, std::string _objectFilename,
-                 bool _updateMinDistToUncovered);
+                 bool _updateMinDistToUncovered, bool _perfCounters);
     ~StatsTracker();
 
     // called after a new StackFrame has been pushed (for callpath tracing)
@@ -75,6 +100,13 @@ namespace klee {
     // called when execution is done and stats files should be flushed
     void done();
 
+    // writes the current statistics without waiting for the timers
+    void checkpoint();
+
+    // waits until the background jobs are done, they must not run while
+    // the module is changed (e.g. when slices are added)
+    void waitForService();
+
     // process stats for a single instruction step, es is the state
     // about to be stepped
     void stepInstruction(ExecutionState &es);
@@ -13,6 +13,8 @@
 #include "klee/ExecutionState.h"
 #include "klee/Solver.h"
 #include "klee/Statistics.h"
+#include "klee/Internal/Support/PhaseTrace.h"
+#include "klee/Internal/System/PerfCounters.h"
 #include "klee/Internal/System/Time.h"
 
 #include "CoreStats.h"
@@ -32,6 +34,8 @@ bool TimingSolver::evaluate(const ExecutionState& state, ref<Expr> expr,
     return true;
   }
 
+  trace::PhaseScope tracePhase(trace::Solver);
+  perf::PhaseScope perfPhase(perf::Solver);
   sys::TimeValue now = util::getWallTimeVal();
 
   if (simplifyExprs)
@@ -43,6 +47,8 @@ bool TimingSolver::evaluate(const ExecutionState& state, ref<Expr> expr,
   delta -= now;
   stats::solverTime += delta.usec();
   state.queryCost += delta.usec()/1000000.;
+  if (costTracker)
+    costTracker->record(origin, state, delta.usec());
 
   return success;
 }
@@ -55,6 +61,8 @@ bool TimingSolver::mustBeTrue(const ExecutionState& state, ref<Expr> expr,
     return true;
   }
 
+  trace::PhaseScope tracePhase(trace::Solver);
+  perf::PhaseScope perfPhase(perf::Solver);
   sys::TimeValue now = util::getWallTimeVal();
 
   if (simplifyExprs)
@@ -66,6 +74,8 @@ bool TimingSolver::mustBeTrue(const ExecutionState& state, ref<Expr> expr,
   delta -= now;
   stats::solverTime += delta.usec();
   state.queryCost += delta.usec()/1000000.;
+  if (costTracker)
+    costTracker->record(origin, state, delta.usec());
 
   return success;
 }
@@ -101,6 +111,8 @@ bool TimingSolver::getValue(const ExecutionState& state, ref<Expr> expr,
     return true;
   }
   
+  trace::PhaseScope tracePhase(trace::Solver);
+  perf::PhaseScope perfPhase(perf::Solver);
   sys::TimeValue now = util::getWallTimeVal();
 
   if (simplifyExprs)
@@ -112,6 +124,8 @@ bool TimingSolver::getValue(const ExecutionState& state, ref<Expr> expr,
   delta -= now;
   stats::solverTime += delta.usec();
   state.queryCost += delta.usec()/1000000.;
+  if (costTracker)
+    costTracker->record(origin, state, delta.usec());
 
   return success;
 }
@@ -125,6 +139,8 @@ TimingSolver::getInitialValues(const ExecutionState& state,
   if (objects.empty())
     return true;
 
+  trace::PhaseScope tracePhase(trace::Solver);
+  perf::PhaseScope perfPhase(perf::Solver);
   sys::TimeValue now = util::getWallTimeVal();
 
   bool success = solver->getInitialValues(Query(state.constraints,
@@ -135,6 +151,8 @@ TimingSolver::getInitialValues(const ExecutionState& state,
   delta -= now;
   stats::solverTime += delta.usec();
   state.queryCost += delta.usec()/1000000.;
+  if (costTracker)
+    costTracker->record(origin, state, delta.usec());
   
   return success;
 }
@@ -13,6 +13,8 @@
 #include "klee/Expr.h"
 #include "klee/Solver.h"
 
+#include "SolverCostTracker.h"
+
 #include <vector>
 
 namespace klee {
@@ -25,17 +27,40 @@ namespace klee {
   public:
     Solver *solver;
     bool simplifyExprs;
+    /// Where the solver time is attributed, if not null (owned).
+    SolverCostTracker *costTracker;
+    /// The origin of the current queries (see OriginScope).
+    QueryOrigin origin;
 
   public:
+    /// OriginScope - Sets the origin of the queries for the lifetime of
+    /// the object. The outermost scope wins, so that for example the
+    /// concretizations done while resolving an address are charged to the
+    /// resolution.
+    class OriginScope {
+      TimingSolver *solver;
+      QueryOrigin previous;
+
+    public:
+      OriginScope(TimingSolver *_solver, QueryOrigin origin)
+          : solver(_solver), previous(_solver->origin) {
+        if (previous == QO_Other)
+          solver->origin = origin;
+      }
+      ~OriginScope() { solver->origin = previous; }
+    };
+
     /// TimingSolver - Construct a new timing solver.
     ///
     /// \param _simplifyExprs - Whether expressions should be
     /// simplified (via the constraint manager interface) prior to
     /// querying.
     TimingSolver(Solver *_solver, bool _simplifyExprs = true) 
-      : solver(_solver), simplifyExprs(_simplifyExprs) {}
+      : solver(_solver), simplifyExprs(_simplifyExprs), costTracker(0),
+        origin(QO_Other) {}
     ~TimingSolver() {
       delete solver;
+      delete costTracker;
     }
 
     void setTimeout(double t) {
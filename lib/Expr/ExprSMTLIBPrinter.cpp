@@ -98,6 +98,19 @@ void ExprSMTLIBPrinter::reset() {
 
 bool ExprSMTLIBPrinter::isHumanReadable() { return humanReadable; }
 
+void ExprSMTLIBPrinter::setExpression(const ref<Expr> &e) {
+  query = NULL;
+  reset();
+  scan(e);
+
+  if (abbrMode == ABBR_LET)
+    scanBindingExprDeps();
+}
+
+void ExprSMTLIBPrinter::printAssertion(const ref<Expr> &e) {
+  printAssert(e);
+}
+
 bool ExprSMTLIBPrinter::setConstantDisplayMode(ConstantDisplayMode cdm) {
   if (cdm > DECIMAL)
     return false;
@@ -570,11 +583,7 @@ void ExprSMTLIBPrinter::printArrayDeclarations() {
   std::sort(sortedArrays.begin(), sortedArrays.end(), ArrayPtrsByName());
   for (std::vector<const Array *>::iterator it = sortedArrays.begin();
        it != sortedArrays.end(); it++) {
-    *o << "(declare-fun " << (*it)->name << " () "
-                                            "(Array (_ BitVec "
-       << (*it)->getDomain() << ") "
-                                "(_ BitVec " << (*it)->getRange() << ") ) )"
-       << "\n";
+    printArrayDeclarationOnly(*it);
   }
 
   // Set array values for constant values
@@ -582,45 +591,59 @@ void ExprSMTLIBPrinter::printArrayDeclarations() {
     if (humanReadable)
       *o << "; Constant Array Definitions\n";
 
-    const Array *array;
-
     // loop over found arrays
     for (std::vector<const Array *>::iterator it = sortedArrays.begin();
          it != sortedArrays.end(); it++) {
-      array = *it;
-      int byteIndex = 0;
-      if (array->isConstantArray()) {
-        /*loop over elements in the array and generate an assert statement
-          for each one
-         */
-        for (std::vector<ref<ConstantExpr> >::const_iterator
-                 ce = array->constantValues.begin();
-             ce != array->constantValues.end(); ce++, byteIndex++) {
-          *p << "(assert (";
-          p->pushIndent();
-          *p << "= ";
-          p->pushIndent();
-          printSeperator();
-
-          *p << "(select " << array->name << " (_ bv" << byteIndex << " "
-             << array->getDomain() << ") )";
-          printSeperator();
-          printConstant((*ce));
-
-          p->popIndent();
-          printSeperator();
-          *p << ")";
-          p->popIndent();
-          printSeperator();
-          *p << ")";
-
-          p->breakLineI();
-        }
-      }
+      if ((*it)->isConstantArray())
+        printConstantArrayValues(*it);
     }
   }
 }
 
+void ExprSMTLIBPrinter::printArrayDeclaration(const Array *array) {
+  printArrayDeclarationOnly(array);
+  if (array->isConstantArray())
+    printConstantArrayValues(array);
+}
+
+void ExprSMTLIBPrinter::printArrayDeclarationOnly(const Array *array) {
+  *o << "(declare-fun " << array->name << " () "
+                                          "(Array (_ BitVec "
+     << array->getDomain() << ") "
+                              "(_ BitVec " << array->getRange() << ") ) )"
+     << "\n";
+}
+
+void ExprSMTLIBPrinter::printConstantArrayValues(const Array *array) {
+  /*loop over elements in the array and generate an assert statement
+    for each one
+   */
+  int byteIndex = 0;
+  for (std::vector<ref<ConstantExpr> >::const_iterator
+           ce = array->constantValues.begin();
+       ce != array->constantValues.end(); ce++, byteIndex++) {
+    *p << "(assert (";
+    p->pushIndent();
+    *p << "= ";
+    p->pushIndent();
+    printSeperator();
+
+    *p << "(select " << array->name << " (_ bv" << byteIndex << " "
+       << array->getDomain() << ") )";
+    printSeperator();
+    printConstant((*ce));
+
+    p->popIndent();
+    printSeperator();
+    *p << ")";
+    p->popIndent();
+    printSeperator();
+    *p << ")";
+
+    p->breakLineI();
+  }
+}
+
 void ExprSMTLIBPrinter::printHumanReadableQuery() {
   assert(humanReadable && "method must be called in humanReadable mode");
   *o << "; Constraints\n";
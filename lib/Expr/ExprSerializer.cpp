@@ -0,0 +1,529 @@
+//===-- ExprSerializer.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/util/ExprSerializer.h"
+
+#include "klee/ExprBuilder.h"
+#include "klee/util/ArrayCache.h"
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstring>
+
+using namespace klee;
+using namespace klee::serialization;
+
+bool serialization::isSerialized(const char *begin, const char *end) {
+  return (size_t)(end - begin) > sizeof(Magic) &&
+         memcmp(begin, Magic, sizeof(Magic)) == 0;
+}
+
+/***/
+
+ExprSerializer::ExprSerializer(llvm::raw_ostream &_os) : os(_os) {
+  os.write(Magic, sizeof(Magic));
+  os << (char) Version;
+}
+
+void ExprSerializer::writeVarint(uint64_t value) {
+  do {
+    unsigned char byte = value & 0x7F;
+    value >>= 7;
+    if (value)
+      byte |= 0x80;
+    os << (char) byte;
+  } while (value);
+}
+
+void ExprSerializer::writeString(const std::string &s) {
+  writeVarint(s.size());
+  os << s;
+}
+
+void ExprSerializer::writeConstant(const ConstantExpr *ce) {
+  const llvm::APInt &value = ce->getAPValue();
+  writeVarint(ce->getWidth());
+  for (unsigned i = 0; i != value.getNumWords(); i++)
+    writeVarint(value.getRawData()[i]);
+}
+
+unsigned ExprSerializer::write(const Array *array) {
+  std::map<const Array*, unsigned>::iterator it = arrays.find(array);
+  if (it != arrays.end())
+    return it->second;
+
+  os << (char) ArrayRecord;
+  writeString(array->name);
+  writeVarint(array->size);
+  writeVarint(array->domain);
+  writeVarint(array->range);
+  os << (char) array->isConstantArray();
+  for (unsigned i = 0; i != array->constantValues.size(); i++)
+    writeConstant(array->constantValues[i].get());
+
+  unsigned id = arrays.size();
+  arrays.insert(std::make_pair(array, id));
+  return id;
+}
+
+/* returns the number of the update node plus one, or zero for the end of the
+   list */
+unsigned ExprSerializer::writeUpdate(const UpdateNode *un) {
+  /* the nodes which were not written yet, newest first */
+  std::vector<const UpdateNode*> pending;
+  for (; un; un = un->next) {
+    if (updates.count(un))
+      break;
+    pending.push_back(un);
+  }
+
+  unsigned next = un ? updates[un] + 1 : 0;
+  for (std::vector<const UpdateNode*>::reverse_iterator
+         it = pending.rbegin(), ie = pending.rend(); it != ie; ++it) {
+    const UpdateNode *node = *it;
+    unsigned index = write(node->index);
+    unsigned value = write(node->value);
+    os << (char) UpdateRecord;
+    writeVarint(next);
+    writeVarint(index);
+    writeVarint(value);
+
+    unsigned id = updates.size();
+    updates.insert(std::make_pair(node, id));
+    /* the numbers are kept by address, so the node must not be freed */
+    keptUpdates.push_back(UpdateList(0, node));
+    next = id + 1;
+  }
+  return next;
+}
+
+unsigned ExprSerializer::write(const ref<Expr> &e) {
+  ExprHashMap<unsigned>::iterator it = exprs.find(e);
+  if (it != exprs.end())
+    return it->second;
+
+  /* the operands are written first */
+  std::vector<unsigned> operands;
+  if (ReadExpr *re = dyn_cast<ReadExpr>(e)) {
+    operands.push_back(write(re->updates.root));
+    operands.push_back(writeUpdate(re->updates.head));
+  }
+  for (unsigned i = 0; i != e->getNumKids(); i++)
+    operands.push_back(write(e->getKid(i)));
+
+  os << (char) ExprRecord;
+  os << (char) e->getKind();
+  switch (e->getKind()) {
+  case Expr::Constant:
+    writeConstant(cast<ConstantExpr>(e));
+    break;
+
+  case Expr::Extract:
+    writeVarint(operands[0]);
+    writeVarint(cast<ExtractExpr>(e)->offset);
+    writeVarint(e->getWidth());
+    break;
+
+  case Expr::ZExt:
+  case Expr::SExt:
+    writeVarint(operands[0]);
+    writeVarint(e->getWidth());
+    break;
+
+  default:
+    /* read: array, update list, index; the others: their kids */
+    for (unsigned i = 0; i != operands.size(); i++)
+      writeVarint(operands[i]);
+    break;
+  }
+
+  unsigned id = exprs.size();
+  exprs.insert(std::make_pair(e, id));
+  return id;
+}
+
+void ExprSerializer::writeQuery(const std::vector< ref<Expr> > &constraints,
+                                const ref<Expr> &query,
+                                const std::vector< ref<Expr> > &values,
+                                const std::vector<const Array*> &objects) {
+  std::vector<unsigned> ids;
+  for (unsigned i = 0; i != constraints.size(); i++)
+    ids.push_back(write(constraints[i]));
+  ids.push_back(write(query));
+  for (unsigned i = 0; i != values.size(); i++)
+    ids.push_back(write(values[i]));
+  for (unsigned i = 0; i != objects.size(); i++)
+    ids.push_back(write(objects[i]));
+
+  os << (char) QueryRecord;
+  std::vector<unsigned>::iterator it = ids.begin();
+  writeVarint(constraints.size());
+  for (unsigned i = 0; i != constraints.size(); i++)
+    writeVarint(*it++);
+  writeVarint(*it++);
+  writeVarint(values.size());
+  for (unsigned i = 0; i != values.size(); i++)
+    writeVarint(*it++);
+  writeVarint(objects.size());
+  for (unsigned i = 0; i != objects.size(); i++)
+    writeVarint(*it++);
+}
+
+/***/
+
+ExprDeserializer::ExprDeserializer(const char *begin, const char *_end,
+                                   ExprBuilder *_builder,
+                                   ArrayCache *_arrayCache)
+  : pos((const unsigned char*) begin),
+    end((const unsigned char*) _end),
+    builder(_builder),
+    arrayCache(_arrayCache) {
+  if (!isSerialized(begin, _end)) {
+    fail("not a serialized expression stream");
+  } else if ((unsigned char) begin[sizeof(Magic)] != Version) {
+    fail("unsupported version " +
+         llvm::utostr((unsigned char) begin[sizeof(Magic)]));
+  } else {
+    pos += sizeof(Magic) + 1;
+  }
+}
+
+bool ExprDeserializer::fail(const std::string &message) {
+  if (error.empty())
+    error = message;
+  /* stop reading */
+  pos = end;
+  return false;
+}
+
+bool ExprDeserializer::readByte(unsigned char &value) {
+  if (pos == end)
+    return fail("unexpected end of stream");
+  value = *pos++;
+  return true;
+}
+
+bool ExprDeserializer::readVarint(uint64_t &value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    unsigned char byte;
+    if (!readByte(byte))
+      return false;
+    value |= (uint64_t) (byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return fail("invalid number");
+}
+
+bool ExprDeserializer::readString(std::string &s) {
+  uint64_t size;
+  if (!readVarint(size))
+    return false;
+  if (size > (uint64_t) (end - pos))
+    return fail("unexpected end of stream");
+  s.assign((const char*) pos, size);
+  pos += size;
+  return true;
+}
+
+bool ExprDeserializer::readConstant(llvm::APInt &value) {
+  uint64_t width;
+  if (!readVarint(width))
+    return false;
+  /* every word takes at least one byte */
+  uint64_t numWords = (width + 63) / 64;
+  if (!width || width > ~0u || numWords > (uint64_t) (end - pos))
+    return fail("invalid constant width");
+
+  std::vector<uint64_t> words;
+  for (uint64_t i = 0; i != numWords; i++) {
+    uint64_t word;
+    if (!readVarint(word))
+      return false;
+    words.push_back(word);
+  }
+  value = llvm::APInt(width, words);
+  return true;
+}
+
+bool ExprDeserializer::readExprRef(ref<Expr> &e) {
+  uint64_t id;
+  if (!readVarint(id))
+    return false;
+  if (id >= exprs.size())
+    return fail("invalid expression number");
+  e = exprs[id];
+  return true;
+}
+
+bool ExprDeserializer::readArrayRef(const Array *&array) {
+  uint64_t id;
+  if (!readVarint(id))
+    return false;
+  if (id >= arrays.size())
+    return fail("invalid array number");
+  array = arrays[id];
+  return true;
+}
+
+bool ExprDeserializer::readArray() {
+  std::string name;
+  uint64_t size, domain, range;
+  unsigned char isConstant;
+  if (!readString(name) || !readVarint(size) || !readVarint(domain) ||
+      !readVarint(range) || !readByte(isConstant))
+    return false;
+  if (!domain || !range)
+    return fail("invalid array width");
+
+  std::vector< ref<ConstantExpr> > values;
+  if (isConstant) {
+    for (uint64_t i = 0; i != size; i++) {
+      llvm::APInt value;
+      if (!readConstant(value))
+        return false;
+      if (value.getBitWidth() != range)
+        return fail("invalid array value width");
+      values.push_back(ConstantExpr::alloc(value));
+    }
+  }
+
+  const Array *array;
+  if (values.empty())
+    array = arrayCache->CreateArray(name, size, 0, 0, domain, range);
+  else
+    array = arrayCache->CreateArray(name, size, &values[0],
+                                    &values[0] + values.size(), domain, range);
+  arrays.push_back(array);
+  return true;
+}
+
+bool ExprDeserializer::readUpdate() {
+  uint64_t next;
+  ref<Expr> index, value;
+  if (!readVarint(next) || !readExprRef(index) || !readExprRef(value))
+    return false;
+  if (next > updates.size())
+    return fail("invalid update number");
+
+  /* the root is only known by the reads of the list */
+  UpdateList ul(0, next ? updates[next - 1].head : 0);
+  ul.extend(index, value);
+  updates.push_back(ul);
+  return true;
+}
+
+bool ExprDeserializer::readExpr() {
+  unsigned char kind;
+  if (!readByte(kind))
+    return false;
+
+  ref<Expr> result;
+  switch (kind) {
+  case Expr::Constant: {
+    llvm::APInt value;
+    if (!readConstant(value))
+      return false;
+    result = builder->Constant(value);
+    break;
+  }
+
+  case Expr::NotOptimized: {
+    ref<Expr> src;
+    if (!readExprRef(src))
+      return false;
+    result = builder->NotOptimized(src);
+    break;
+  }
+
+  case Expr::Read: {
+    const Array *array;
+    uint64_t update;
+    ref<Expr> index;
+    if (!readArrayRef(array) || !readVarint(update) || !readExprRef(index))
+      return false;
+    if (update > updates.size())
+      return fail("invalid update number");
+    if (index->getWidth() != array->domain)
+      return fail("invalid read index width");
+    result = builder->Read(UpdateList(array,
+                                      update ? updates[update - 1].head : 0),
+                           index);
+    break;
+  }
+
+  case Expr::Select: {
+    ref<Expr> cond, t, f;
+    if (!readExprRef(cond) || !readExprRef(t) || !readExprRef(f))
+      return false;
+    if (cond->getWidth() != Expr::Bool || t->getWidth() != f->getWidth())
+      return fail("invalid select widths");
+    result = builder->Select(cond, t, f);
+    break;
+  }
+
+  case Expr::Concat: {
+    ref<Expr> left, right;
+    if (!readExprRef(left) || !readExprRef(right))
+      return false;
+    result = builder->Concat(left, right);
+    break;
+  }
+
+  case Expr::Extract: {
+    ref<Expr> src;
+    uint64_t offset, width;
+    if (!readExprRef(src) || !readVarint(offset) || !readVarint(width))
+      return false;
+    if (!width || offset + width > src->getWidth())
+      return fail("invalid extract range");
+    result = builder->Extract(src, offset, width);
+    break;
+  }
+
+  case Expr::ZExt:
+  case Expr::SExt: {
+    ref<Expr> src;
+    uint64_t width;
+    if (!readExprRef(src) || !readVarint(width))
+      return false;
+    if (width < src->getWidth() || width > ~0u)
+      return fail("invalid cast width");
+    if (kind == Expr::ZExt)
+      result = builder->ZExt(src, width);
+    else
+      result = builder->SExt(src, width);
+    break;
+  }
+
+  case Expr::Not: {
+    ref<Expr> src;
+    if (!readExprRef(src))
+      return false;
+    result = builder->Not(src);
+    break;
+  }
+
+  default: {
+    if (kind < Expr::BinaryKindFirst || kind > Expr::BinaryKindLast)
+      return fail("invalid expression kind " + llvm::utostr(kind));
+
+    ref<Expr> left, right;
+    if (!readExprRef(left) || !readExprRef(right))
+      return false;
+    if (left->getWidth() != right->getWidth())
+      return fail("invalid operand widths");
+
+    switch (kind) {
+    case Expr::Add:  result = builder->Add(left, right); break;
+    case Expr::Sub:  result = builder->Sub(left, right); break;
+    case Expr::Mul:  result = builder->Mul(left, right); break;
+    case Expr::UDiv: result = builder->UDiv(left, right); break;
+    case Expr::SDiv: result = builder->SDiv(left, right); break;
+    case Expr::URem: result = builder->URem(left, right); break;
+    case Expr::SRem: result = builder->SRem(left, right); break;
+    case Expr::And:  result = builder->And(left, right); break;
+    case Expr::Or:   result = builder->Or(left, right); break;
+    case Expr::Xor:  result = builder->Xor(left, right); break;
+    case Expr::Shl:  result = builder->Shl(left, right); break;
+    case Expr::LShr: result = builder->LShr(left, right); break;
+    case Expr::AShr: result = builder->AShr(left, right); break;
+    case Expr::Eq:   result = builder->Eq(left, right); break;
+    case Expr::Ne:   result = builder->Ne(left, right); break;
+    case Expr::Ult:  result = builder->Ult(left, right); break;
+    case Expr::Ule:  result = builder->Ule(left, right); break;
+    case Expr::Ugt:  result = builder->Ugt(left, right); break;
+    case Expr::Uge:  result = builder->Uge(left, right); break;
+    case Expr::Slt:  result = builder->Slt(left, right); break;
+    case Expr::Sle:  result = builder->Sle(left, right); break;
+    case Expr::Sgt:  result = builder->Sgt(left, right); break;
+    case Expr::Sge:  result = builder->Sge(left, right); break;
+    default:
+      return fail("invalid expression kind " + llvm::utostr(kind));
+    }
+    break;
+  }
+  }
+
+  exprs.push_back(result);
+  return true;
+}
+
+bool ExprDeserializer::readExprList(std::vector< ref<Expr> > &result) {
+  uint64_t n;
+  if (!readVarint(n))
+    return false;
+  for (uint64_t i = 0; i != n; i++) {
+    ref<Expr> e;
+    if (!readExprRef(e))
+      return false;
+    result.push_back(e);
+  }
+  return true;
+}
+
+bool ExprDeserializer::readQuery(std::vector< ref<Expr> > &constraints,
+                                 ref<Expr> &query,
+                                 std::vector< ref<Expr> > &values,
+                                 std::vector<const Array*> &objects) {
+  while (pos != end) {
+    unsigned char tag;
+    if (!readByte(tag))
+      return false;
+
+    switch (tag) {
+    case ArrayRecord:
+      if (!readArray())
+        return false;
+      break;
+    case UpdateRecord:
+      if (!readUpdate())
+        return false;
+      break;
+    case ExprRecord:
+      if (!readExpr())
+        return false;
+      break;
+    case QueryRecord: {
+      constraints.clear();
+      values.clear();
+      objects.clear();
+      if (!readExprList(constraints) || !readExprRef(query) ||
+          !readExprList(values))
+        return false;
+      uint64_t n;
+      if (!readVarint(n))
+        return false;
+      for (uint64_t i = 0; i != n; i++) {
+        const Array *array;
+        if (!readArrayRef(array))
+          return false;
+        objects.push_back(array);
+      }
+      return true;
+    }
+    default:
+      return fail("invalid record " + llvm::utostr(tag));
+    }
+  }
+  return false;
+}
+
+bool ExprDeserializer::readAll() {
+  std::vector< ref<Expr> > constraints, values;
+  ref<Expr> query;
+  std::vector<const Array*> objects;
+  while (readQuery(constraints, query, values, objects))
+    ;
+  return error.empty();
+}
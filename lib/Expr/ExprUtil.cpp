@@ -14,6 +14,7 @@
 
 #include "klee/util/ExprVisitor.h"
 
+#include <map>
 #include <set>
 
 using namespace klee;
@@ -76,6 +77,92 @@ void klee::findReads(ref<Expr> e,
 
 ///
 
+namespace {
+
+class ComplexityMeasure {
+  unsigned maxNodes;
+  unsigned maxDepth;
+  unsigned nodes;
+  /// the height of the visited nodes
+  std::map<const Expr *, unsigned> heights;
+
+public:
+  bool exceeded;
+
+  ComplexityMeasure(unsigned _maxNodes, unsigned _maxDepth)
+    : maxNodes(_maxNodes), maxDepth(_maxDepth), nodes(0), exceeded(false) {}
+
+  /// Returns the height of e, which is at the given level (the root is at
+  /// level 1). The level bounds the recursion when the depth is limited.
+  unsigned visit(const Expr *e, unsigned level) {
+    if (isa<ConstantExpr>(e))
+      return 1;
+
+    std::map<const Expr *, unsigned>::iterator it = heights.find(e);
+    if (it != heights.end()) {
+      if (maxDepth && level + it->second - 1 > maxDepth)
+        exceeded = true;
+      return it->second;
+    }
+
+    if ((maxNodes && ++nodes > maxNodes) || (maxDepth && level > maxDepth)) {
+      exceeded = true;
+      return 0;
+    }
+
+    unsigned height = 0;
+    if (const ReadExpr *re = dyn_cast<ReadExpr>(e)) {
+      // the update list is not traversed, each update is a write on the
+      // path which the solver has to consider
+      unsigned updates = re->updates.getSize();
+      nodes += updates;
+      height = updates;
+      if ((maxNodes && nodes > maxNodes) ||
+          (maxDepth && level + height > maxDepth)) {
+        exceeded = true;
+        return 0;
+      }
+    }
+
+    for (unsigned i = 0; i < e->getNumKids(); i++) {
+      unsigned h = visit(e->getKid(i).get(), level + 1);
+      if (exceeded)
+        return 0;
+      if (h > height)
+        height = h;
+    }
+
+    heights[e] = height + 1;
+    return height + 1;
+  }
+};
+
+}
+
+bool klee::exceedsComplexity(ref<Expr> e, unsigned maxNodes,
+                             unsigned maxDepth) {
+  ComplexityMeasure measure(maxNodes, maxDepth);
+  measure.visit(e.get(), 1);
+  return measure.exceeded;
+}
+
+bool klee::getConstantArrayRuns(const Array *array, unsigned maxRuns,
+                                ConstantArrayRuns &runs) {
+  assert(array->isConstantArray() && "runs of a symbolic array");
+  runs.clear();
+  for (unsigned i = 0; i < array->size; i++) {
+    const ref<ConstantExpr> &value = array->constantValues[i];
+    if (!runs.empty() && runs.back().second == value)
+      continue;
+    if (runs.size() == maxRuns) {
+      runs.clear();
+      return false;
+    }
+    runs.push_back(std::make_pair(i, value));
+  }
+  return true;
+}
+
 namespace klee {
 
 class SymbolicObjectFinder : public ExprVisitor {
@@ -125,3 +212,6 @@ template void klee::findSymbolicObjects<A>(A, A, std::vector<const Array*> &);
 
 typedef std::set< ref<Expr> >::iterator B;
 template void klee::findSymbolicObjects<B>(B, B, std::vector<const Array*> &);
+
+typedef std::vector< ref<Expr> >::const_iterator C;
+template void klee::findSymbolicObjects<C>(C, C, std::vector<const Array*> &);
@@ -16,6 +16,7 @@
 #include "klee/ExprBuilder.h"
 #include "klee/Solver.h"
 #include "klee/util/ExprPPrinter.h"
+#include "klee/util/ExprSerializer.h"
 #include "klee/util/ArrayCache.h"
 
 #include "llvm/ADT/APInt.h"
@@ -120,7 +121,9 @@ namespace {
     // FIXME: Use LLVM symbol tables?
     IdentifierTabTy IdentifierTab;
 
-    std::map<const Identifier*, const ArrayDecl*> ArraySymTab;
+    /// ArraySymTab - The declared arrays. The decls themselves are owned
+    /// by the caller, which may delete them as soon as they are returned.
+    std::map<const Identifier*, const Array*> ArraySymTab;
     ExprSymTabTy ExprSymTab;
     VersionSymTabTy VersionSymTab;
 
@@ -530,7 +533,7 @@ DeclResult ParserImpl::ParseArrayDecl() {
   ArrayDecl *AD = new ArrayDecl(Label, Size.get(), 
                                 DomainType.get(), RangeType.get(), Root);
 
-  ArraySymTab[Label] = AD;
+  ArraySymTab[Label] = Root;
 
   // Create the initial version reference.
   VersionSymTab.insert(std::make_pair(Label,
@@ -579,10 +582,10 @@ DeclResult ParserImpl::ParseQueryCommand() {
 
   // Reinsert initial array versions.
   // FIXME: Remove this!
-  for (std::map<const Identifier*, const ArrayDecl*>::iterator
+  for (std::map<const Identifier*, const Array*>::iterator
          it = ArraySymTab.begin(), ie = ArraySymTab.end(); it != ie; ++it) {
-    VersionSymTab.insert(std::make_pair(it->second->Name,
-                                        UpdateList(it->second->Root, NULL)));
+    VersionSymTab.insert(std::make_pair(it->first,
+                                        UpdateList(it->second, NULL)));
   }
 
 
@@ -666,13 +669,13 @@ DeclResult ParserImpl::ParseQueryCommand() {
     ConsumeToken();
 
     // Lookup array.
-    std::map<const Identifier*, const ArrayDecl*>::iterator
+    std::map<const Identifier*, const Array*>::iterator
       it = ArraySymTab.find(Label);
 
     if (it == ArraySymTab.end()) {
       Error("unknown array", LTok);
     } else {
-      Objects.push_back(it->second->Root);
+      Objects.push_back(it->second);
     }
   }
   ConsumeRSquare();
@@ -1637,6 +1640,44 @@ void QueryCommand::dump() {
                            false);
 }
 
+namespace {
+  /// BinaryParser - Reads the queries of a stream written by
+  /// ExprSerializer. The arrays are shared by the queries of the stream,
+  /// so they are never cleared.
+  class BinaryParser : public Parser {
+    const std::string Filename;
+    ArrayCache TheArrayCache;
+    ExprDeserializer Reader;
+    unsigned NumErrors;
+
+  public:
+    BinaryParser(const std::string _Filename, const MemoryBuffer *MB,
+                 ExprBuilder *Builder)
+      : Filename(_Filename),
+        Reader(MB->getBufferStart(), MB->getBufferEnd(), Builder,
+               &TheArrayCache),
+        NumErrors(0) {}
+
+    virtual Decl *ParseTopLevelDecl() {
+      std::vector<ExprHandle> Constraints, Values;
+      ExprHandle Query;
+      std::vector<const Array*> Objects;
+      if (Reader.readQuery(Constraints, Query, Values, Objects))
+        return new QueryCommand(Constraints, Query, Values, Objects);
+
+      if (!Reader.getError().empty() && !NumErrors++)
+        llvm::errs() << Filename << ": error: " << Reader.getError() << "\n";
+      return 0;
+    }
+
+    virtual void SetMaxErrors(unsigned N) {}
+
+    virtual unsigned GetNumErrors() const {
+      return NumErrors;
+    }
+  };
+}
+
 // Public parser API
 
 Parser::Parser() {
@@ -1647,6 +1688,9 @@ Parser::~Parser() {
 
 Parser *Parser::Create(const std::string Filename, const MemoryBuffer *MB,
                        ExprBuilder *Builder, bool ClearArrayAfterQuery) {
+  if (serialization::isSerialized(MB->getBufferStart(), MB->getBufferEnd()))
+    return new BinaryParser(Filename, MB, Builder);
+
   ParserImpl *P = new ParserImpl(Filename, MB, Builder, ClearArrayAfterQuery);
   P->Initialize();
   return P;
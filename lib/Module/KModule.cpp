@@ -19,6 +19,7 @@
 #include "klee/Internal/Module/KInstruction.h"
 #include "klee/Internal/Module/InstructionInfoTable.h"
 #include "klee/Internal/Support/Debug.h"
+#include "klee/Internal/Support/ModuleCache.h"
 #include "klee/Internal/Support/ModuleUtil.h"
 
 #include "llvm/Bitcode/ReaderWriter.h"
@@ -107,6 +108,26 @@ namespace {
   DebugPrintEscapingFunctions("debug-print-escaping-functions", 
                               cl::desc("Print functions whose address is taken."));
 
+  cl::opt<bool>
+  SpecializeFunctions("specialize-functions",
+                      cl::desc("Clone functions for call sites with constant arguments and fold the constants (default=off)"),
+                      cl::init(false));
+
+  cl::opt<unsigned>
+  SpecializeMaxFunctionSize("specialize-max-function-size",
+                            cl::desc("Maximum number of instructions of a specialized function (default=500)"),
+                            cl::init(500));
+
+  cl::opt<bool>
+  SummarizeLoops("summarize-loops",
+                 cl::desc("Replace the loops which scan a buffer for a byte by a scan which is executed natively (requires optimized bitcode, default=off)"),
+                 cl::init(false));
+
+  cl::opt<unsigned>
+  SpecializeBudget("specialize-budget",
+                   cl::desc("Maximum number of instructions added by specialization (default=20000)"),
+                   cl::init(20000));
+
   cl::opt<bool>
   UseSVFPTA("use-svf-analysis",
             cl::desc("Use SVF pointer analysis for reachability analysis (default=on)"),
@@ -143,6 +164,7 @@ KModule::~KModule() {
 
 namespace llvm {
 extern void Optimize(Module *, const std::string &EntryPoint);
+extern std::string getOptimizeOptions();
 }
 
 // what a hack
@@ -249,15 +271,24 @@ void KModule::addInternalFunction(const char* functionName){
   internalFunctions.insert(internalFunction);
 }
 
-void KModule::prepare(const Interpreter::ModuleOptions &opts,
-		              const std::vector<Interpreter::SkippedFunctionOption> &skippedFunctions,
-                      InterpreterHandler *ih,
-                      ReachabilityAnalysis *ra,
-                      Inliner *inliner,
-                      AAPass *aa,
-                      ModRefAnalysis *mra,
-                      Cloner *cloner,
-                      SliceGenerator *sliceGenerator) {
+std::string klee::getModuleTransformOptions() {
+  std::string result;
+  llvm::raw_string_ostream os(result);
+  for (cl::list<std::string>::iterator it = MergeAtExit.begin(),
+         ie = MergeAtExit.end(); it != ie; ++it)
+    os << "merge-at-exit=" << *it << "\n";
+  os << "switch-type=" << (int) SwitchType << "\n";
+  os << "specialize-functions=" << (SpecializeFunctions ? 1 : 0) << "\n";
+  os << "specialize-max-function-size="
+     << (unsigned) SpecializeMaxFunctionSize << "\n";
+  os << "specialize-budget=" << (unsigned) SpecializeBudget << "\n";
+  os << "summarize-loops=" << (SummarizeLoops ? 1 : 0) << "\n";
+  os << getOptimizeOptions();
+  return os.str();
+}
+
+void KModule::transform(const Interpreter::ModuleOptions &opts,
+                        const std::vector<Interpreter::SkippedFunctionOption> &skippedFunctions) {
   if (!MergeAtExit.empty()) {
     Function *mergeFn = module->getFunction("klee_merge");
     if (!mergeFn) {
@@ -323,10 +354,21 @@ void KModule::prepare(const Interpreter::ModuleOptions &opts,
   // deleted (via RAUW). This can be removed once LLVM fixes this
   // issue.
   pm.add(new IntrinsicCleanerPass(*targetData, false));
+  if (SpecializeFunctions)
+    pm.add(new SpecializeFunctionsPass(*targetData, skippedFunctions,
+                                       SpecializeMaxFunctionSize,
+                                       SpecializeBudget));
   pm.run(*module);
 
   if (opts.Optimize)
     Optimize(module, opts.EntryPoint);
+
+  // the loops are recognized in SSA form, after the optimizations
+  if (SummarizeLoops) {
+    PassManager pm2;
+    pm2.add(new LoopSummaryPass(*targetData));
+    pm2.run(*module);
+  }
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 3)
   // Force importing functions required by intrinsic lowering. Kind of
   // unfortunate clutter when we don't need them but we won't know
@@ -365,14 +407,6 @@ void KModule::prepare(const Interpreter::ModuleOptions &opts,
     );
   module = linkWithLibrary(module, LibPath.str());
 
-  // Add internal functions which are not used to check if instructions
-  // have been already visited
-  if (opts.CheckDivZero)
-    addInternalFunction("klee_div_zero_check");
-  if (opts.CheckOvershift)
-    addInternalFunction("klee_overshift_check");
-
-
   // Needs to happen after linking (since ctors/dtors can be modified)
   // and optimization (since global optimization can rewrite lists).
   injectStaticConstructorsAndDestructors(module);
@@ -404,6 +438,29 @@ void KModule::prepare(const Interpreter::ModuleOptions &opts,
   f = module->getFunction("memset");
   if (f && f->use_empty()) f->eraseFromParent();
 #endif
+}
+
+void KModule::prepare(const Interpreter::ModuleOptions &opts,
+		              const std::vector<Interpreter::SkippedFunctionOption> &skippedFunctions,
+                      InterpreterHandler *ih,
+                      ReachabilityAnalysis *ra,
+                      Inliner *inliner,
+                      AAPass *aa,
+                      ModRefAnalysis *mra,
+                      Cloner *cloner,
+                      SliceGenerator *sliceGenerator) {
+  if (!opts.Prepared) {
+    transform(opts, skippedFunctions);
+    if (!opts.PreparedModuleCache.empty())
+      storeCachedModule(module, opts.PreparedModuleCache);
+  }
+
+  // Add internal functions which are not used to check if instructions
+  // have been already visited
+  if (opts.CheckDivZero)
+    addInternalFunction("klee_div_zero_check");
+  if (opts.CheckOvershift)
+    addInternalFunction("klee_overshift_check");
 
   // Write out the .ll assembly file. We truncate long lines to work
   // around a kcachegrind parsing bug (it puts them on new lines), so
@@ -0,0 +1,379 @@
+//===-- LoopSummary.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Passes.h"
+
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#include "klee/Config/Version.h"
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#else
+#include "llvm/Instructions.h"
+#include "llvm/Module.h"
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 2)
+#include "llvm/IRBuilder.h"
+#else
+#include "llvm/Support/IRBuilder.h"
+#endif
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+#include "llvm/Target/TargetData.h"
+#else
+#include "llvm/DataLayout.h"
+#endif
+#endif
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 5)
+#include "llvm/IR/CFG.h"
+#else
+#include "llvm/Support/CFG.h"
+#endif
+
+#include <set>
+#include <vector>
+
+using namespace llvm;
+
+char klee::LoopSummaryPass::ID = 0;
+
+namespace {
+
+/// An induction variable of a scan loop: phi = [init, preheader],
+/// [next, loop] where next = phi + step.
+struct Induction {
+  PHINode *phi;
+  Value *init;
+  Instruction *next;
+  int64_t step;
+};
+
+/// A single block loop which loads one byte per iteration, at consecutive
+/// addresses, and exits at the first byte which satisfies a condition
+/// computed from the byte alone.
+struct ScanLoop {
+  BasicBlock *loop;
+  BasicBlock *preheader;
+  BasicBlock *exit;
+  std::vector<Induction> inductions;
+  /// the induction variable which gives the address of the byte (either a
+  /// pointer, or an index into base)
+  unsigned scanned;
+  /// 1 if the byte is read through the next value of the induction
+  /// variable (as in rotated loops), 0 otherwise
+  unsigned scannedOffset;
+  Value *base;
+  GetElementPtrInst *address;
+  LoadInst *load;
+  /// from the loaded byte to the comparison
+  std::vector<Instruction *> chain;
+  ICmpInst *cmp;
+  bool exitOnTrue;
+};
+
+bool matchInduction(PHINode *phi, BasicBlock *loop, BasicBlock *preheader,
+                    Induction &induction) {
+  if (phi->getNumIncomingValues() != 2)
+    return false;
+
+  induction.phi = phi;
+  induction.init = phi->getIncomingValueForBlock(preheader);
+  Instruction *next =
+    dyn_cast<Instruction>(phi->getIncomingValueForBlock(loop));
+  if (!next || next->getParent() != loop)
+    return false;
+  induction.next = next;
+
+  if (BinaryOperator *bo = dyn_cast<BinaryOperator>(next)) {
+    ConstantInt *step = dyn_cast<ConstantInt>(bo->getOperand(1));
+    if (bo->getOpcode() != Instruction::Add || bo->getOperand(0) != phi ||
+        !step)
+      return false;
+    induction.step = step->getSExtValue();
+    return true;
+  }
+
+  if (GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(next)) {
+    if (gep->getPointerOperand() != phi || gep->getNumIndices() != 1)
+      return false;
+    ConstantInt *step = dyn_cast<ConstantInt>(gep->getOperand(1));
+    if (!step)
+      return false;
+    induction.step = step->getSExtValue();
+    return true;
+  }
+
+  return false;
+}
+
+/// The instructions which may compute the exit condition from the byte.
+bool isChainInstruction(Instruction *i) {
+  switch (i->getOpcode()) {
+  case Instruction::ZExt:
+  case Instruction::SExt:
+  case Instruction::Trunc:
+    return true;
+  case Instruction::Add:
+  case Instruction::Sub:
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+    return isa<ConstantInt>(i->getOperand(1));
+  default:
+    return false;
+  }
+}
+
+bool matchScanLoop(BasicBlock *bb, ScanLoop &loop) {
+  BranchInst *br = dyn_cast<BranchInst>(bb->getTerminator());
+  if (!br || !br->isConditional())
+    return false;
+  if (br->getSuccessor(0) == bb && br->getSuccessor(1) != bb) {
+    loop.exit = br->getSuccessor(1);
+    loop.exitOnTrue = false;
+  } else if (br->getSuccessor(1) == bb && br->getSuccessor(0) != bb) {
+    loop.exit = br->getSuccessor(0);
+    loop.exitOnTrue = true;
+  } else {
+    return false;
+  }
+  loop.loop = bb;
+
+  // the loop is entered from a single preheader
+  loop.preheader = 0;
+  for (pred_iterator i = pred_begin(bb), e = pred_end(bb); i != e; ++i) {
+    if (*i == bb)
+      continue;
+    if (loop.preheader)
+      return false;
+    loop.preheader = *i;
+  }
+  if (!loop.preheader || loop.preheader == loop.exit)
+    return false;
+  BranchInst *entry = dyn_cast<BranchInst>(loop.preheader->getTerminator());
+  if (!entry || entry->isConditional())
+    return false;
+
+  // the exit condition is computed from a loaded byte
+  loop.cmp = dyn_cast<ICmpInst>(br->getCondition());
+  if (!loop.cmp || loop.cmp->getParent() != bb || !loop.cmp->hasOneUse() ||
+      !isa<ConstantInt>(loop.cmp->getOperand(1)))
+    return false;
+  Instruction *i = dyn_cast<Instruction>(loop.cmp->getOperand(0));
+  loop.chain.clear();
+  while (i && i->getParent() == bb && i->hasOneUse() &&
+         isChainInstruction(i)) {
+    loop.chain.insert(loop.chain.begin(), i);
+    i = dyn_cast<Instruction>(i->getOperand(0));
+  }
+  loop.load = dyn_cast_or_null<LoadInst>(i);
+  if (!loop.load || loop.load->getParent() != bb || !loop.load->hasOneUse() ||
+      loop.load->isVolatile() || !loop.load->getType()->isIntegerTy(8))
+    return false;
+
+  for (BasicBlock::iterator i = bb->begin(); isa<PHINode>(i); ++i) {
+    Induction induction;
+    if (!matchInduction(cast<PHINode>(i), bb, loop.preheader, induction))
+      return false;
+    loop.inductions.push_back(induction);
+  }
+
+  // the byte is read through a pointer which is incremented by one, or at
+  // an index which is incremented by one
+  Value *pointer = loop.load->getPointerOperand();
+  loop.address = dyn_cast<GetElementPtrInst>(pointer);
+  if (loop.address) {
+    if (loop.address->getParent() != bb ||
+        loop.address->getNumIndices() != 1)
+      return false;
+    loop.base = loop.address->getPointerOperand();
+    if (Instruction *base = dyn_cast<Instruction>(loop.base))
+      if (base->getParent() == bb)
+        return false;
+    pointer = loop.address->getOperand(1);
+    for (Value::use_iterator u = loop.address->use_begin();
+         u != loop.address->use_end(); ++u)
+      if (cast<Instruction>(*u)->getParent() != bb)
+        return false;
+  } else {
+    loop.base = 0;
+  }
+  bool found = false;
+  for (unsigned n = 0; n < loop.inductions.size(); n++) {
+    const Induction &induction = loop.inductions[n];
+    if (induction.step != 1)
+      continue;
+    if (induction.phi == pointer || induction.next == pointer) {
+      loop.scanned = n;
+      loop.scannedOffset = induction.phi == pointer ? 0 : 1;
+      found = true;
+    }
+  }
+  if (!found)
+    return false;
+
+  // nothing else is done in the loop
+  std::set<Instruction *> known;
+  for (unsigned n = 0; n < loop.inductions.size(); n++) {
+    known.insert(loop.inductions[n].phi);
+    known.insert(loop.inductions[n].next);
+  }
+  if (loop.address)
+    known.insert(loop.address);
+  known.insert(loop.load);
+  known.insert(loop.chain.begin(), loop.chain.end());
+  known.insert(loop.cmp);
+  known.insert(br);
+  for (BasicBlock::iterator i = bb->begin(); i != bb->end(); ++i)
+    if (!known.count(i))
+      return false;
+
+  return true;
+}
+
+/// Creates the scan function of a loop: it takes the address of the first
+/// byte, and returns the number of bytes which do not satisfy the exit
+/// condition before the first one which does.
+Function *createScanFunction(Module &m, const ScanLoop &loop,
+                             Type *countType) {
+  LLVMContext &ctx = m.getContext();
+  Type *bytePtrType = Type::getInt8PtrTy(ctx);
+  FunctionType *type = FunctionType::get(countType, bytePtrType, false);
+  Function *f = Function::Create(type, GlobalValue::InternalLinkage,
+                                 "__klee_loop_scan", &m);
+  f->addFnAttr(Attribute::NoInline);
+  f->addFnAttr(Attribute::ReadOnly);
+  Value *start = f->arg_begin();
+
+  BasicBlock *entry = BasicBlock::Create(ctx, "entry", f);
+  BasicBlock *body = BasicBlock::Create(ctx, "loop", f);
+  BasicBlock *exit = BasicBlock::Create(ctx, "exit", f);
+
+  IRBuilder<> builder(entry);
+  builder.CreateBr(body);
+
+  builder.SetInsertPoint(body);
+  PHINode *count = builder.CreatePHI(countType, 2, "count");
+  Value *address = builder.CreateGEP(start, count);
+  Value *value = builder.CreateLoad(address);
+  for (std::vector<Instruction *>::const_iterator i = loop.chain.begin();
+       i != loop.chain.end(); ++i) {
+    Instruction *clone = (*i)->clone();
+    clone->setOperand(0, value);
+    builder.Insert(clone);
+    value = clone;
+  }
+  Value *cmp = builder.CreateICmp(loop.cmp->getPredicate(), value,
+                                  loop.cmp->getOperand(1));
+  Value *next = builder.CreateAdd(count, ConstantInt::get(countType, 1));
+  if (loop.exitOnTrue)
+    builder.CreateCondBr(cmp, exit, body);
+  else
+    builder.CreateCondBr(cmp, body, exit);
+  count->addIncoming(ConstantInt::get(countType, 0), entry);
+  count->addIncoming(next, body);
+
+  builder.SetInsertPoint(exit);
+  builder.CreateRet(count);
+  return f;
+}
+
+/// Returns the value of an induction variable after count iterations.
+Value *getValueAfter(IRBuilder<> &builder, const Induction &induction,
+                     Value *count, int64_t extra) {
+  Type *type = induction.phi->getType();
+  if (type->isPointerTy()) {
+    Value *offset = builder.CreateAdd(
+      builder.CreateMul(count, ConstantInt::get(count->getType(),
+                                                induction.step)),
+      ConstantInt::get(count->getType(), extra * induction.step));
+    return builder.CreateGEP(induction.init, offset);
+  }
+
+  Value *n = builder.CreateZExtOrTrunc(count, type);
+  Value *offset = builder.CreateAdd(
+    builder.CreateMul(n, ConstantInt::get(type, induction.step)),
+    ConstantInt::get(type, extra * induction.step));
+  return builder.CreateAdd(induction.init, offset);
+}
+
+void replaceUsesOutside(Instruction *i, Value *value, const ScanLoop &loop) {
+  std::vector<Use *> uses;
+  for (Value::use_iterator u = i->use_begin(); u != i->use_end(); ++u)
+    if (cast<Instruction>(*u)->getParent() != loop.loop)
+      uses.push_back(&u.getUse());
+  for (std::vector<Use *>::iterator u = uses.begin(); u != uses.end(); ++u)
+    (*u)->set(value);
+}
+
+void summarize(ScanLoop &loop, Function *scan) {
+  IRBuilder<> builder(loop.preheader->getTerminator());
+
+  const Induction &scanned = loop.inductions[loop.scanned];
+  Value *start = scanned.init;
+  if (loop.scannedOffset) {
+    if (start->getType()->isPointerTy())
+      start = builder.CreateGEP(start, builder.getInt32(1));
+    else
+      start = builder.CreateAdd(start, ConstantInt::get(start->getType(), 1));
+  }
+  if (loop.base)
+    start = builder.CreateGEP(loop.base, start);
+  if (start->getType() != scan->getFunctionType()->getParamType(0))
+    start = builder.CreateBitCast(start,
+                                  scan->getFunctionType()->getParamType(0));
+  Value *count = builder.CreateCall(scan, start, "trip.count");
+
+  // the values of the induction variables at the exit
+  for (std::vector<Induction>::iterator i = loop.inductions.begin();
+       i != loop.inductions.end(); ++i) {
+    replaceUsesOutside(i->phi, getValueAfter(builder, *i, count, 0), loop);
+    replaceUsesOutside(i->next, getValueAfter(builder, *i, count, 1), loop);
+  }
+
+  // the exit is entered from the preheader instead of the loop
+  for (BasicBlock::iterator i = loop.exit->begin(); isa<PHINode>(i); ++i) {
+    PHINode *phi = cast<PHINode>(i);
+    for (unsigned n = 0; n < phi->getNumIncomingValues(); n++)
+      if (phi->getIncomingBlock(n) == loop.loop)
+        phi->setIncomingBlock(n, loop.preheader);
+  }
+  loop.preheader->getTerminator()->eraseFromParent();
+  BranchInst::Create(loop.exit, loop.preheader);
+
+  loop.loop->dropAllReferences();
+  loop.loop->eraseFromParent();
+}
+
+}
+
+bool klee::LoopSummaryPass::runOnModule(Module &M) {
+  Type *countType = DataLayout.getIntPtrType(M.getContext());
+
+  std::vector<ScanLoop> loops;
+  for (Module::iterator f = M.begin(); f != M.end(); ++f) {
+    for (Function::iterator bb = f->begin(); bb != f->end(); ++bb) {
+      ScanLoop loop;
+      if (matchScanLoop(bb, loop))
+        loops.push_back(loop);
+    }
+  }
+
+  for (std::vector<ScanLoop>::iterator i = loops.begin(); i != loops.end();
+       ++i) {
+    Function *scan = createScanFunction(M, *i, countType);
+    summarize(*i, scan);
+  }
+
+  if (!loops.empty())
+    klee_message("summarized %u scanning loops",
+                 (unsigned) loops.size());
+  return !loops.empty();
+}
@@ -0,0 +1,150 @@
+//===-- ModuleCache.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/Support/ModuleCache.h"
+
+#include "klee/Config/Version.h"
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#else
+#include "llvm/LLVMContext.h"
+#include "llvm/Module.h"
+#endif
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/system_error.h"
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace klee;
+
+bool ModuleCacheKey::addFile(const std::string &path) {
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+  OwningPtr<MemoryBuffer> buffer;
+  if (MemoryBuffer::getFile(path, buffer))
+    return false;
+#else
+  auto buffer = MemoryBuffer::getFile(path);
+  if (!buffer)
+    return false;
+#endif
+
+  /* the name is hashed as well, so that the files can not be confused */
+  addString(path);
+  hash.update((*buffer)->getBuffer());
+  return true;
+}
+
+void ModuleCacheKey::addString(const std::string &s) {
+  hash.update(s);
+  /* separator */
+  hash.update(StringRef("", 1));
+}
+
+std::string ModuleCacheKey::getPath(const std::string &cacheDir) {
+  MD5::MD5Result result;
+  hash.final(result);
+  SmallString<32> digest;
+  MD5::stringifyResult(result, digest);
+
+  SmallString<128> path(cacheDir);
+  sys::path::append(path, digest.str() + ".bc");
+  return path.str();
+}
+
+Module *klee::loadCachedModule(const std::string &path, LLVMContext &ctx) {
+  bool exists = false;
+  if (sys::fs::exists(path, exists) || !exists)
+    return 0;
+
+  std::string ErrorMsg;
+  Module *module = 0;
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+  OwningPtr<MemoryBuffer> BufferPtr;
+  if (MemoryBuffer::getFile(path, BufferPtr))
+    return 0;
+
+  module = getLazyBitcodeModule(BufferPtr.get(), ctx, &ErrorMsg);
+  if (module) {
+    /* the buffer is owned by the module once it is loaded */
+    BufferPtr.take();
+    if (module->MaterializeAllPermanently(&ErrorMsg)) {
+      delete module;
+      module = 0;
+    }
+  }
+#else
+  auto Buffer = MemoryBuffer::getFile(path);
+  if (!Buffer)
+    return 0;
+
+  auto moduleOrError = getLazyBitcodeModule(Buffer->get(), ctx);
+  if (!moduleOrError) {
+    ErrorMsg = moduleOrError.getError().message();
+  } else {
+    Buffer->release();
+    module = *moduleOrError;
+    if (auto ec = module->materializeAllPermanently()) {
+      ErrorMsg = ec.message();
+      delete module;
+      module = 0;
+    }
+  }
+#endif
+
+  if (!module)
+    klee_warning("unable to load the cached module %s: %s", path.c_str(),
+                 ErrorMsg.c_str());
+  return module;
+}
+
+void klee::storeCachedModule(Module *module, const std::string &path) {
+  std::string tmpPath = path + "." + llvm::utostr(getpid()) + ".tmp";
+
+  std::string Error;
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3,5)
+  raw_fd_ostream os(tmpPath.c_str(), Error, sys::fs::F_None);
+#elif LLVM_VERSION_CODE >= LLVM_VERSION(3,4)
+  raw_fd_ostream os(tmpPath.c_str(), Error, sys::fs::F_Binary);
+#else
+  raw_fd_ostream os(tmpPath.c_str(), Error, raw_fd_ostream::F_Binary);
+#endif
+  if (!Error.empty()) {
+    klee_warning("unable to write the cached module %s: %s", tmpPath.c_str(),
+                 Error.c_str());
+    return;
+  }
+
+  WriteBitcodeToFile(module, os);
+  os.close();
+  if (os.has_error()) {
+    os.clear_error();
+    klee_warning("unable to write the cached module %s", tmpPath.c_str());
+    unlink(tmpPath.c_str());
+    return;
+  }
+
+  if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+    klee_warning("unable to write the cached module %s", path.c_str());
+    unlink(tmpPath.c_str());
+  }
+}
@@ -44,6 +44,7 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Support/PluginLoader.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace llvm;
 
 // Don't verify at the end
@@ -160,6 +161,20 @@ static void AddStandardCompilePasses(PassManager &PM) {
   addPass(PM, createConstantMergePass());        // Merge dup global constants
 }
 
+/// getOptimizeOptions - Describe the options which change the result of
+/// Optimize.
+std::string getOptimizeOptions() {
+  std::string result;
+  raw_string_ostream os(result);
+  os << "disable-verify=" << (DontVerify ? 1 : 0) << "\n"
+     << "disable-inlining=" << (DisableInline ? 1 : 0) << "\n"
+     << "disable-opt=" << (DisableOptimizations ? 1 : 0) << "\n"
+     << "disable-internalize=" << (DisableInternalize ? 1 : 0) << "\n"
+     << "strip-all=" << (Strip ? 1 : 0) << "\n"
+     << "strip-debug=" << (StripDebug ? 1 : 0) << "\n";
+  return os.str();
+}
+
 /// Optimize - Perform link time optimizations. This will run the scalar
 /// optimizations, any loaded plugin-optimization modules, and then the
 /// inter-procedural optimizations if applicable.
@@ -182,6 +182,79 @@ private:
                      llvm::BasicBlock *defaultBlock);
 };
 
+/// SpecializeFunctionsPass - Clones functions for call sites which pass
+/// constant arguments, and folds the constants into the clone. Call sites
+/// which share the same constants share the same clone. The total number of
+/// cloned instructions is bounded by a budget.
+class SpecializeFunctionsPass : public llvm::ModulePass {
+  static char ID;
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+  const llvm::TargetData &TargetData;
+#else
+  const llvm::DataLayout &DataLayout;
+#endif
+  const std::vector<Interpreter::SkippedFunctionOption> skippedFunctions;
+  unsigned maxFunctionSize;
+  unsigned budget;
+
+  typedef std::vector< std::pair<unsigned, llvm::Constant *> > ConstantArgs;
+  typedef std::pair<llvm::Function *, ConstantArgs> SpecializationKey;
+
+  bool isSpecializable(llvm::Function *f);
+  bool getConstantArgs(llvm::CallInst *callInst, ConstantArgs &args);
+  llvm::Function *specialize(llvm::Function *f, const ConstantArgs &args);
+  void simplify(llvm::Function *f);
+  static bool hasMoreCallSites(const std::pair<unsigned, SpecializationKey> &a,
+                               const std::pair<unsigned, SpecializationKey> &b);
+
+public:
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+  SpecializeFunctionsPass(const llvm::TargetData &TD,
+#else
+  SpecializeFunctionsPass(const llvm::DataLayout &TD,
+#endif
+                          const std::vector<Interpreter::SkippedFunctionOption> &_skippedFunctions,
+                          unsigned _maxFunctionSize,
+                          unsigned _budget)
+    : llvm::ModulePass(ID),
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+      TargetData(TD),
+#else
+      DataLayout(TD),
+#endif
+      skippedFunctions(_skippedFunctions),
+      maxFunctionSize(_maxFunctionSize),
+      budget(_budget) {}
+
+  virtual bool runOnModule(llvm::Module &M);
+};
+
+/// LoopSummaryPass - Replaces the single block loops which scan a byte
+/// buffer for the first byte satisfying a condition (a delimiter, a
+/// non-digit...) by a call to a scan function, which returns the number of
+/// iterations. The induction variables of the loop are computed from it at
+/// the exit. The executor runs the scan functions natively, with a trip
+/// count expression instead of a fork per iteration (see
+/// SpecialFunctionHandler::modelLoopScan).
+class LoopSummaryPass : public llvm::ModulePass {
+  static char ID;
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+  const llvm::TargetData &DataLayout;
+#else
+  const llvm::DataLayout &DataLayout;
+#endif
+
+public:
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+  LoopSummaryPass(const llvm::TargetData &TD)
+#else
+  LoopSummaryPass(const llvm::DataLayout &TD)
+#endif
+    : llvm::ModulePass(ID), DataLayout(TD) {}
+
+  virtual bool runOnModule(llvm::Module &M);
+};
+
 class ReturnToVoidFunctionPass : public llvm::ModulePass {
   static char ID;
   const std::vector<Interpreter::SkippedFunctionOption> skippedFunctions;
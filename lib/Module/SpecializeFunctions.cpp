@@ -0,0 +1,191 @@
+//===-- SpecializeFunctions.cpp -------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Passes.h"
+
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#include "klee/Config/Version.h"
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 3)
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#else
+#include "llvm/Constants.h"
+#include "llvm/Instructions.h"
+#include "llvm/IntrinsicInst.h"
+#include "llvm/Module.h"
+#endif
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3, 5)
+#include "llvm/IR/InstIterator.h"
+#else
+#include "llvm/Support/InstIterator.h"
+#endif
+#include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace llvm;
+
+char klee::SpecializeFunctionsPass::ID = 0;
+
+static unsigned getInstructionsCount(Function *f) {
+  unsigned count = 0;
+  for (Function::iterator bb = f->begin(); bb != f->end(); bb++) {
+    count += bb->size();
+  }
+  return count;
+}
+
+bool klee::SpecializeFunctionsPass::hasMoreCallSites(const std::pair<unsigned, SpecializationKey> &a,
+                                                    const std::pair<unsigned, SpecializationKey> &b) {
+  return a.first > b.first;
+}
+
+bool klee::SpecializeFunctionsPass::isSpecializable(Function *f) {
+  if (f->isDeclaration() || f->isVarArg() || f->isIntrinsic()) {
+    return false;
+  }
+
+  /* runtime functions are recognized by name */
+  std::string name = f->getName().str();
+  if (name.find("klee_") == 0) {
+    return false;
+  }
+
+  /* skipped functions are recognized by name as well */
+  for (std::vector<Interpreter::SkippedFunctionOption>::const_iterator i = skippedFunctions.begin();
+       i != skippedFunctions.end(); i++) {
+    if (i->name == name || i->name == std::string("__wrap_") + name) {
+      return false;
+    }
+  }
+
+  return getInstructionsCount(f) <= maxFunctionSize;
+}
+
+bool klee::SpecializeFunctionsPass::getConstantArgs(CallInst *callInst, ConstantArgs &args) {
+  for (unsigned i = 0; i < callInst->getNumArgOperands(); i++) {
+    Value *arg = callInst->getArgOperand(i);
+    if (isa<ConstantInt>(arg) || isa<ConstantFP>(arg) || isa<ConstantPointerNull>(arg)) {
+      args.push_back(std::make_pair(i, cast<Constant>(arg)));
+    }
+  }
+
+  return !args.empty();
+}
+
+Function *klee::SpecializeFunctionsPass::specialize(Function *f, const ConstantArgs &args) {
+  ValueToValueMapTy vmap;
+  Function *clone = CloneFunction(f, vmap, false);
+  clone->setName(f->getName() + ".specialized");
+  clone->setLinkage(GlobalValue::InternalLinkage);
+  f->getParent()->getFunctionList().push_back(clone);
+
+  /* the signature is kept, so only the call target has to be replaced */
+  std::vector<Argument *> formals;
+  for (Function::arg_iterator i = clone->arg_begin(); i != clone->arg_end(); i++) {
+    formals.push_back(i);
+  }
+  for (ConstantArgs::const_iterator i = args.begin(); i != args.end(); i++) {
+    formals[i->first]->replaceAllUsesWith(i->second);
+  }
+
+  simplify(clone);
+  return clone;
+}
+
+/// Folds the propagated constants. The cloned instructions keep their debug
+/// locations, and the unreachable blocks are removed later by the CFG
+/// simplification which runs in KModule::prepare.
+void klee::SpecializeFunctionsPass::simplify(Function *f) {
+#if LLVM_VERSION_CODE <= LLVM_VERSION(3, 1)
+  const llvm::TargetData *td = &TargetData;
+#else
+  const llvm::DataLayout *td = &DataLayout;
+#endif
+  bool changed;
+  do {
+    changed = false;
+    for (inst_iterator i = inst_begin(f), e = inst_end(f); i != e; ) {
+      Instruction *inst = &*i++;
+      if (Constant *c = ConstantFoldInstruction(inst, td)) {
+        inst->replaceAllUsesWith(c);
+        inst->eraseFromParent();
+        changed = true;
+      }
+    }
+
+    for (Function::iterator bb = f->begin(); bb != f->end(); bb++) {
+      if (ConstantFoldTerminator(bb, true)) {
+        changed = true;
+      }
+    }
+  } while (changed);
+}
+
+bool klee::SpecializeFunctionsPass::runOnModule(Module &M) {
+  /* group the call sites which pass the same constants to the same function */
+  std::map<SpecializationKey, std::vector<CallInst *> > groups;
+  for (Module::iterator f = M.begin(); f != M.end(); f++) {
+    for (inst_iterator i = inst_begin(f), e = inst_end(f); i != e; i++) {
+      CallInst *callInst = dyn_cast<CallInst>(&*i);
+      if (!callInst) {
+        continue;
+      }
+
+      Function *callee = callInst->getCalledFunction();
+      if (!callee || callee == f || !isSpecializable(callee)) {
+        continue;
+      }
+
+      ConstantArgs args;
+      if (getConstantArgs(callInst, args)) {
+        groups[std::make_pair(callee, args)].push_back(callInst);
+      }
+    }
+  }
+
+  /* the groups with more call sites are specialized first */
+  std::vector< std::pair<unsigned, SpecializationKey> > order;
+  for (std::map<SpecializationKey, std::vector<CallInst *> >::iterator i = groups.begin();
+       i != groups.end(); i++) {
+    order.push_back(std::make_pair(i->second.size(), i->first));
+  }
+  std::stable_sort(order.begin(), order.end(), hasMoreCallSites);
+
+  unsigned used = 0;
+  unsigned specialized = 0;
+  for (unsigned i = 0; i < order.size(); i++) {
+    SpecializationKey &key = order[i].second;
+    unsigned size = getInstructionsCount(key.first);
+    if (used + size > budget) {
+      continue;
+    }
+
+    Function *clone = specialize(key.first, key.second);
+    std::vector<CallInst *> &callSites = groups[key];
+    for (std::vector<CallInst *>::iterator j = callSites.begin(); j != callSites.end(); j++) {
+      (*j)->setCalledFunction(clone);
+    }
+
+    used += size;
+    specialized++;
+  }
+
+  if (specialized) {
+    klee_message("specialized %u functions (%u instructions)", specialized, used);
+  }
+
+  return specialized != 0;
+}
@@ -89,6 +89,10 @@ Solver *createCoreSolver(CoreSolverType cst) {
     llvm::errs() << "Not compiled with Z3 support\n";
     return NULL;
 #endif
+  case SMTLIB_SOLVER:
+    llvm::errs() << "Using SMT-LIB solver backend (" << SMTLIBSolverCommand
+                 << ")\n";
+    return new SMTLIBSolver(SMTLIBSolverCommand, SMTLIBSolverPoolSize);
   case NO_SOLVER:
     llvm::errs() << "Invalid solver\n";
     return NULL;
@@ -0,0 +1,611 @@
+//===-- SMTLIBSolver.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#include "klee/Solver.h"
+#include "klee/SolverImpl.h"
+#include "klee/SolverStats.h"
+#include "klee/Statistics.h"
+#include "klee/TimerStatIncrementer.h"
+#include "klee/Internal/Support/ErrorHandling.h"
+#include "klee/Internal/System/Time.h"
+#include "klee/util/Assignment.h"
+#include "klee/util/ExprSMTLIBPrinter.h"
+#include "klee/util/ExprUtil.h"
+
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace klee;
+
+#ifdef MSG_NOSIGNAL
+static const int sendFlags = MSG_NOSIGNAL;
+#else
+static const int sendFlags = 0;
+#endif
+
+namespace {
+
+/// A parsed response of the solver, either an atom or a list.
+struct SExpr {
+  std::string atom;
+  std::vector<SExpr> children;
+  bool isList;
+
+  SExpr() : isList(false) {}
+};
+
+/// Parses a single s-expression starting at \a pos. Returns false if the
+/// text is not a complete s-expression.
+bool parseSExpr(const std::string &text, size_t &pos, SExpr &result) {
+  while (pos < text.size() && isspace(text[pos]))
+    pos++;
+  if (pos == text.size())
+    return false;
+
+  if (text[pos] == '(') {
+    pos++;
+    result.isList = true;
+    for (;;) {
+      while (pos < text.size() && isspace(text[pos]))
+        pos++;
+      if (pos == text.size())
+        return false;
+      if (text[pos] == ')') {
+        pos++;
+        return true;
+      }
+      result.children.push_back(SExpr());
+      if (!parseSExpr(text, pos, result.children.back()))
+        return false;
+    }
+  }
+
+  if (text[pos] == ')')
+    return false;
+
+  /* string literals and quoted symbols may contain spaces */
+  if (text[pos] == '"' || text[pos] == '|') {
+    char quote = text[pos];
+    size_t end = text.find(quote, pos + 1);
+    if (end == std::string::npos)
+      return false;
+    result.atom = text.substr(pos, end + 1 - pos);
+    pos = end + 1;
+    return true;
+  }
+
+  size_t start = pos;
+  while (pos < text.size() && !isspace(text[pos]) && text[pos] != '(' &&
+         text[pos] != ')')
+    pos++;
+  result.atom = text.substr(start, pos - start);
+  return true;
+}
+
+/// Parses a byte value of a model, given as #xHH, #bBBBBBBBB or (_ bvN 8).
+bool parseByte(const SExpr &value, unsigned char &byte) {
+  const char *digits;
+  int base;
+  if (value.isList) {
+    if (value.children.size() != 3 || value.children[0].atom != "_" ||
+        value.children[1].atom.compare(0, 2, "bv") != 0)
+      return false;
+    digits = value.children[1].atom.c_str() + 2;
+    base = 10;
+  } else if (value.atom.compare(0, 2, "#x") == 0) {
+    digits = value.atom.c_str() + 2;
+    base = 16;
+  } else if (value.atom.compare(0, 2, "#b") == 0) {
+    digits = value.atom.c_str() + 2;
+    base = 2;
+  } else {
+    return false;
+  }
+
+  char *end;
+  unsigned long result = strtoul(digits, &end, base);
+  if (*digits == '\0' || *end != '\0' || result > 255)
+    return false;
+  byte = (unsigned char)result;
+  return true;
+}
+
+bool writeAll(int fd, const std::string &data) {
+  const char *pos = data.data();
+  size_t size = data.size();
+  while (size) {
+    ssize_t n = ::send(fd, pos, size, sendFlags);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    pos += n;
+    size -= n;
+  }
+  return true;
+}
+
+}
+
+namespace klee {
+
+class SMTLIBSolverImpl : public SolverImpl {
+private:
+  /// The assertions which are pushed at one level of the solver stack,
+  /// together with the arrays declared at that level.
+  struct Level {
+    ref<Expr> constraint;
+    std::vector<const Array *> arrays;
+  };
+
+  /// A long-running solver process. Every constraint of the last query is
+  /// kept in its own level, so that a query which shares a prefix of the
+  /// constraints only has to pop the levels which differ.
+  struct Process {
+    pid_t pid;
+    /// Our end of the socket pair, which is the stdin and stdout of the
+    /// solver.
+    int fd;
+    /// The data which was read, but not parsed yet.
+    std::string buffer;
+    std::vector<Level> levels;
+    std::set<const Array *> declared;
+
+    Process() : pid(-1), fd(-1) {}
+  };
+
+  std::string command;
+  std::vector<Process> processes;
+  double timeout;
+  SolverRunStatus runStatusCode;
+  ExprSMTLIBPrinter printer;
+
+  bool spawn(Process &process);
+  void kill(Process &process);
+  bool send(Process &process, const std::string &commands);
+  bool receive(Process &process, SExpr &response, double deadline);
+
+  Process &selectProcess(const std::vector<ref<Expr> > &constraints,
+                         unsigned &shared);
+  void printLevel(Process &process, llvm::raw_ostream &os, ref<Expr> e);
+  void popLevels(Process &process, llvm::raw_ostream &os, unsigned count);
+  bool getValues(Process &process, const std::vector<const Array *> &objects,
+                 std::vector<std::vector<unsigned char> > &values,
+                 double deadline);
+
+  bool internalRunSolver(const Query &,
+                         const std::vector<const Array *> *objects,
+                         std::vector<std::vector<unsigned char> > *values,
+                         bool &hasSolution);
+
+public:
+  SMTLIBSolverImpl(const std::string &command, unsigned poolSize);
+  ~SMTLIBSolverImpl();
+
+  char *getConstraintLog(const Query &);
+  void setCoreSolverTimeout(double _timeout) { timeout = _timeout; }
+
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValue(const Query &, ref<Expr> &result);
+  bool computeInitialValues(const Query &,
+                            const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+  SolverRunStatus getOperationStatusCode();
+};
+
+SMTLIBSolverImpl::SMTLIBSolverImpl(const std::string &_command,
+                                   unsigned poolSize)
+    : command(_command), processes(std::max(1u, poolSize)), timeout(0.0),
+      runStatusCode(SOLVER_RUN_STATUS_FAILURE) {}
+
+SMTLIBSolverImpl::~SMTLIBSolverImpl() {
+  for (std::vector<Process>::iterator it = processes.begin();
+       it != processes.end(); ++it) {
+    if (it->pid != -1)
+      kill(*it);
+  }
+}
+
+bool SMTLIBSolverImpl::spawn(Process &process) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+    klee_warning("socketpair failed (for SMT-LIB solver) - %s",
+                 llvm::sys::StrError(errno).c_str());
+    return false;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == -1) {
+    klee_warning("fork failed (for SMT-LIB solver) - %s",
+                 llvm::sys::StrError(errno).c_str());
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    /* the timers and the interrupt handler belong to the executor */
+    struct itimerval t = {};
+    ::setitimer(ITIMER_REAL, &t, 0);
+    ::signal(SIGALRM, SIG_DFL);
+    ::signal(SIGINT, SIG_IGN);
+
+    ::close(fds[0]);
+    ::dup2(fds[1], STDIN_FILENO);
+    ::dup2(fds[1], STDOUT_FILENO);
+    ::close(fds[1]);
+    ::execl("/bin/sh", "sh", "-c", command.c_str(), (char *)NULL);
+    _exit(127);
+  }
+
+  ::close(fds[1]);
+  process.pid = pid;
+  process.fd = fds[0];
+  process.buffer.clear();
+  process.levels.clear();
+  process.declared.clear();
+
+  /* the responses of the successful commands are not read */
+  std::string setup = "(set-option :print-success false)\n"
+                      "(set-option :produce-models true)\n"
+                      "(set-logic QF_AUFBV)\n";
+  if (!send(process, setup)) {
+    klee_warning("unable to start the SMT-LIB solver \"%s\"", command.c_str());
+    kill(process);
+    return false;
+  }
+  return true;
+}
+
+void SMTLIBSolverImpl::kill(Process &process) {
+  ::close(process.fd);
+  ::kill(process.pid, SIGKILL);
+
+  int status;
+  pid_t res;
+  do {
+    res = waitpid(process.pid, &status, 0);
+  } while (res < 0 && errno == EINTR);
+
+  process.pid = -1;
+  process.fd = -1;
+}
+
+bool SMTLIBSolverImpl::send(Process &process, const std::string &commands) {
+  return writeAll(process.fd, commands);
+}
+
+/// Reads the next complete response of the solver, waiting at most until
+/// the deadline (if not zero).
+bool SMTLIBSolverImpl::receive(Process &process, SExpr &response,
+                               double deadline) {
+  for (;;) {
+    size_t pos = 0;
+    SExpr parsed;
+    if (parseSExpr(process.buffer, pos, parsed)) {
+      /* a trailing atom may be incomplete, unless a delimiter follows it */
+      if (parsed.isList || (pos < process.buffer.size())) {
+        process.buffer.erase(0, pos);
+        response = parsed;
+        return true;
+      }
+    }
+
+    int remaining = -1;
+    if (deadline) {
+      double left = deadline - util::getWallTime();
+      remaining = left > 0 ? (int)(left * 1000) + 1 : 0;
+    }
+
+    struct pollfd pfd = { process.fd, POLLIN, 0 };
+    int res = ::poll(&pfd, 1, remaining);
+    if (res == 0) {
+      runStatusCode = SOLVER_RUN_STATUS_TIMEOUT;
+      return false;
+    }
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      klee_warning("poll() for SMT-LIB solver failed - %s",
+                   llvm::sys::StrError(errno).c_str());
+      runStatusCode = SOLVER_RUN_STATUS_WAITPID_FAILED;
+      return false;
+    }
+
+    char data[4096];
+    ssize_t n = ::read(process.fd, data, sizeof(data));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      klee_warning("SMT-LIB solver \"%s\" exited unexpectedly",
+                   command.c_str());
+      runStatusCode = SOLVER_RUN_STATUS_UNEXPECTED_EXIT_CODE;
+      return false;
+    }
+    process.buffer.append(data, n);
+  }
+}
+
+/// Selects the process whose asserted constraints share the longest prefix
+/// with the given constraints. A process which is not running shares
+/// nothing, but it is preferred to the processes which share nothing as
+/// well, so that the pool grows before its states are thrown away.
+SMTLIBSolverImpl::Process &
+SMTLIBSolverImpl::selectProcess(const std::vector<ref<Expr> > &constraints,
+                                unsigned &shared) {
+  Process *best = NULL;
+  shared = 0;
+  for (std::vector<Process>::iterator it = processes.begin();
+       it != processes.end(); ++it) {
+    unsigned count = 0;
+    if (it->pid != -1) {
+      while (count < it->levels.size() && count < constraints.size() &&
+             it->levels[count].constraint == constraints[count])
+        count++;
+    }
+
+    if (!best || count > shared ||
+        (count == shared && shared == 0 && it->pid == -1 && best->pid != -1)) {
+      best = &*it;
+      shared = count;
+    }
+  }
+  return *best;
+}
+
+/// Pushes a new level which declares the arrays that are not declared yet,
+/// and asserts the given expression.
+void SMTLIBSolverImpl::printLevel(Process &process, llvm::raw_ostream &os,
+                                  ref<Expr> e) {
+  process.levels.push_back(Level());
+  Level &level = process.levels.back();
+  level.constraint = e;
+
+  os << "(push 1)\n";
+  printer.setExpression(e);
+  const std::set<const Array *> &arrays = printer.getUsedArrays();
+  for (std::set<const Array *>::const_iterator it = arrays.begin();
+       it != arrays.end(); ++it) {
+    if (process.declared.insert(*it).second) {
+      printer.printArrayDeclaration(*it);
+      level.arrays.push_back(*it);
+    }
+  }
+  printer.printAssertion(e);
+}
+
+void SMTLIBSolverImpl::popLevels(Process &process, llvm::raw_ostream &os,
+                                 unsigned count) {
+  if (!count)
+    return;
+
+  os << "(pop " << count << ")\n";
+  for (unsigned i = 0; i < count; i++) {
+    Level &level = process.levels.back();
+    for (std::vector<const Array *>::iterator it = level.arrays.begin();
+         it != level.arrays.end(); ++it)
+      process.declared.erase(*it);
+    process.levels.pop_back();
+  }
+}
+
+/// Requests the values of all bytes of the objects, with one get-value
+/// command per object.
+bool SMTLIBSolverImpl::getValues(
+    Process &process, const std::vector<const Array *> &objects,
+    std::vector<std::vector<unsigned char> > &values, double deadline) {
+  std::string commands;
+  llvm::raw_string_ostream os(commands);
+  for (std::vector<const Array *>::const_iterator it = objects.begin();
+       it != objects.end(); ++it) {
+    const Array *array = *it;
+    if (!array->size)
+      continue;
+    os << "(get-value (";
+    for (unsigned offset = 0; offset < array->size; offset++)
+      os << "(select " << array->name << " (_ bv" << offset << " "
+         << array->getDomain() << "))";
+    os << "))\n";
+  }
+  if (!send(process, os.str())) {
+    runStatusCode = SOLVER_RUN_STATUS_UNEXPECTED_EXIT_CODE;
+    return false;
+  }
+
+  values.reserve(objects.size());
+  for (std::vector<const Array *>::const_iterator it = objects.begin();
+       it != objects.end(); ++it) {
+    const Array *array = *it;
+    std::vector<unsigned char> data(array->size);
+    if (array->size) {
+      SExpr response;
+      if (!receive(process, response, deadline))
+        return false;
+      if (!response.isList || response.children.size() != array->size) {
+        klee_warning("unexpected response of the SMT-LIB solver to get-value");
+        runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+        return false;
+      }
+      for (unsigned offset = 0; offset < array->size; offset++) {
+        const SExpr &pair = response.children[offset];
+        if (!pair.isList || pair.children.size() != 2 ||
+            !parseByte(pair.children[1], data[offset])) {
+          klee_warning("unable to parse the model of the SMT-LIB solver");
+          runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+          return false;
+        }
+      }
+    }
+    values.push_back(data);
+  }
+  return true;
+}
+
+char *SMTLIBSolverImpl::getConstraintLog(const Query &query) {
+  std::string log;
+  llvm::raw_string_ostream os(log);
+  ExprSMTLIBPrinter logPrinter;
+  logPrinter.setOutput(os);
+  logPrinter.setQuery(query);
+  logPrinter.generateOutput();
+  return strdup(os.str().c_str());
+}
+
+bool SMTLIBSolverImpl::computeTruth(const Query &query, bool &isValid) {
+  bool hasSolution;
+  bool status =
+      internalRunSolver(query, /*objects=*/NULL, /*values=*/NULL, hasSolution);
+  isValid = !hasSolution;
+  return status;
+}
+
+bool SMTLIBSolverImpl::computeValue(const Query &query, ref<Expr> &result) {
+  std::vector<const Array *> objects;
+  std::vector<std::vector<unsigned char> > values;
+  bool hasSolution;
+
+  // Find the object used in the expression, and compute an assignment
+  // for them.
+  findSymbolicObjects(query.expr, objects);
+  if (!computeInitialValues(query.withFalse(), objects, values, hasSolution))
+    return false;
+  assert(hasSolution && "state has invalid constraint set");
+
+  // Evaluate the expression with the computed assignment.
+  Assignment a(objects, values);
+  result = a.evaluate(query.expr);
+
+  return true;
+}
+
+bool SMTLIBSolverImpl::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<std::vector<unsigned char> > &values, bool &hasSolution) {
+  return internalRunSolver(query, &objects, &values, hasSolution);
+}
+
+bool SMTLIBSolverImpl::internalRunSolver(
+    const Query &query, const std::vector<const Array *> *objects,
+    std::vector<std::vector<unsigned char> > *values, bool &hasSolution) {
+  TimerStatIncrementer t(stats::queryTime);
+  ++stats::queries;
+  if (objects)
+    ++stats::queryCounterexamples;
+
+  runStatusCode = SOLVER_RUN_STATUS_FAILURE;
+  double deadline = timeout ? util::getWallTime() + timeout : 0;
+
+  std::vector<ref<Expr> > constraints(query.constraints.begin(),
+                                      query.constraints.end());
+  unsigned shared;
+  Process &process = selectProcess(constraints, shared);
+  if (process.pid == -1 && !spawn(process)) {
+    runStatusCode = SOLVER_RUN_STATUS_FORK_FAILED;
+    return false;
+  }
+
+  std::string commands;
+  llvm::raw_string_ostream os(commands);
+  printer.setOutput(os);
+  popLevels(process, os, process.levels.size() - shared);
+  for (unsigned i = shared; i < constraints.size(); i++)
+    printLevel(process, os, constraints[i]);
+
+  // KLEE Queries are validity queries i.e.
+  // ∀ X Constraints(X) → query(X)
+  // but the solver works in terms of satisfiability so instead we ask the
+  // negation of the equivalent i.e.
+  // ∃ X Constraints(X) ∧ ¬ query(X)
+  // The negated query lives in its own level, which is popped afterwards.
+  printLevel(process, os, Expr::createIsZero(query.expr));
+  if (objects) {
+    for (std::vector<const Array *>::const_iterator it = objects->begin();
+         it != objects->end(); ++it) {
+      if (process.declared.insert(*it).second) {
+        printer.printArrayDeclaration(*it);
+        process.levels.back().arrays.push_back(*it);
+      }
+    }
+  }
+  os << "(check-sat)\n";
+
+  SExpr response;
+  if (!send(process, os.str())) {
+    klee_warning("unable to send the query to the SMT-LIB solver");
+    runStatusCode = SOLVER_RUN_STATUS_UNEXPECTED_EXIT_CODE;
+    kill(process);
+    return false;
+  }
+  if (!receive(process, response, deadline)) {
+    if (runStatusCode == SOLVER_RUN_STATUS_TIMEOUT)
+      klee_warning("SMT-LIB solver timed out");
+    kill(process);
+    return false;
+  }
+
+  if (response.atom == "sat") {
+    hasSolution = true;
+    runStatusCode = SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+    if (objects && !getValues(process, *objects, *values, deadline)) {
+      kill(process);
+      return false;
+    }
+  } else if (response.atom == "unsat") {
+    hasSolution = false;
+    runStatusCode = SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE;
+  } else {
+    if (response.atom != "unknown")
+      klee_warning("unexpected response of the SMT-LIB solver to check-sat");
+    kill(process);
+    return false;
+  }
+
+  std::string pop;
+  llvm::raw_string_ostream popStream(pop);
+  popLevels(process, popStream, 1);
+  if (!send(process, popStream.str()))
+    kill(process);
+
+  if (hasSolution) {
+    ++stats::queriesInvalid;
+  } else {
+    ++stats::queriesValid;
+  }
+  return true;
+}
+
+SolverImpl::SolverRunStatus SMTLIBSolverImpl::getOperationStatusCode() {
+  return runStatusCode;
+}
+
+SMTLIBSolver::SMTLIBSolver(const std::string &command, unsigned poolSize)
+    : Solver(new SMTLIBSolverImpl(command, poolSize)) {}
+
+char *SMTLIBSolver::getConstraintLog(const Query &query) {
+  return impl->getConstraintLog(query);
+}
+
+void SMTLIBSolver::setCoreSolverTimeout(double timeout) {
+  impl->setCoreSolverTimeout(timeout);
+}
+}
@@ -14,6 +14,7 @@
 #include "klee/Solver.h"
 #include "klee/util/Bits.h"
 #include "klee/SolverStats.h"
+#include "klee/CommandLine.h"
 
 #include "ConstantDivision.h"
 
@@ -464,6 +465,32 @@ ExprHandle STPBuilder::constructSDivByConstant(ExprHandle expr_n, unsigned width
   return(array_expr); 
 }
 
+const ConstantArrayRuns &STPBuilder::getLookupTable(const Array *root) {
+  std::map<const Array *, ConstantArrayRuns>::iterator it =
+    lookupTables.find(root);
+  if (it != lookupTables.end())
+    return it->second;
+
+  ConstantArrayRuns &runs = lookupTables[root];
+  getConstantArrayRuns(root, LookupTableMaxRuns, runs);
+  return runs;
+}
+
+/// Builds a binary search over the runs [begin, end) of a constant array.
+ExprHandle STPBuilder::constructLookup(const ConstantArrayRuns &runs,
+                                       ExprHandle index, unsigned indexWidth,
+                                       unsigned begin, unsigned end) {
+  if (end - begin == 1)
+    return construct(runs[begin].second, 0);
+
+  unsigned mid = begin + (end - begin) / 2;
+  return vc_iteExpr(vc,
+                    vc_bvLtExpr(vc, index,
+                                bvConst32(indexWidth, runs[mid].first)),
+                    constructLookup(runs, index, indexWidth, begin, mid),
+                    constructLookup(runs, index, indexWidth, mid, end));
+}
+
 ExprHandle STPBuilder::getInitialRead(const Array *root, unsigned index) {
   return vc_readExpr(vc, getInitialArray(root), bvConst32(32, index));
 }
@@ -559,6 +586,18 @@ ExprHandle STPBuilder::constructActual(ref<Expr> e, int *width_out) {
     ReadExpr *re = cast<ReadExpr>(e);
     assert(re && re->updates.root);
     *width_out = re->updates.root->getRange();
+
+    // lookup tables are encoded without an array
+    if (!re->updates.head && re->updates.root->isConstantArray() &&
+        LookupTableMaxRuns) {
+      const ConstantArrayRuns &runs = getLookupTable(re->updates.root);
+      if (!runs.empty()) {
+        ++stats::queryLookupTables;
+        return constructLookup(runs, construct(re->index, 0),
+                               re->updates.root->getDomain(), 0, runs.size());
+      }
+    }
+
     return vc_readExpr(vc,
                        getArrayForUpdate(re->updates.root, re->updates.head),
                        construct(re->index, 0));
@@ -12,8 +12,11 @@
 
 #include "klee/util/ExprHashMap.h"
 #include "klee/util/ArrayExprHash.h"
+#include "klee/util/ExprUtil.h"
 #include "klee/Config/config.h"
 
+#include <map>
+
 #include <vector>
 
 #define Expr VCExpr
@@ -73,6 +76,10 @@ class STPBuilder {
 
   STPArrayExprHash _arr_hash;
 
+  /// The runs of the constant arrays read at symbolic indices, empty if an
+  /// array has too many runs (see -lookup-table-max-runs).
+  std::map<const Array *, ConstantArrayRuns> lookupTables;
+
 private:  
 
   ExprHandle bvOne(unsigned width);
@@ -105,6 +112,11 @@ private:
   ::VCExpr getInitialArray(const Array *os);
   ::VCExpr getArrayForUpdate(const Array *root, const UpdateNode *un);
 
+  const ConstantArrayRuns &getLookupTable(const Array *root);
+  ExprHandle constructLookup(const ConstantArrayRuns &runs, ExprHandle index,
+                             unsigned indexWidth, unsigned begin,
+                             unsigned end);
+
   ExprHandle constructActual(ref<Expr> e, int *width_out);
   ExprHandle construct(ref<Expr> e, int *width_out);
   
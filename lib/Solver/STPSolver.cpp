@@ -9,16 +9,22 @@
 #include "klee/Config/config.h"
 #ifdef ENABLE_STP
 #include "STPBuilder.h"
+#include "STPWorkerPool.h"
 #include "klee/Solver.h"
 #include "klee/SolverImpl.h"
 #include "klee/Constraints.h"
 #include "klee/Internal/Support/ErrorHandling.h"
+#include "klee/ExprBuilder.h"
 #include "klee/util/Assignment.h"
+#include "klee/util/ExprPPrinter.h"
 #include "klee/util/ExprUtil.h"
+#include "expr/Parser.h"
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Errno.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <errno.h>
 #include <unistd.h>
@@ -36,6 +42,15 @@ llvm::cl::opt<bool> DebugDumpSTPQueries(
 llvm::cl::opt<bool> IgnoreSolverFailures(
     "ignore-solver-failures", llvm::cl::init(false),
     llvm::cl::desc("Ignore any solver failures (default=off)"));
+
+llvm::cl::opt<bool> UseSTPWorkers(
+    "use-stp-workers", llvm::cl::init(true),
+    llvm::cl::desc("In forked mode, send the queries to long-lived STP "
+                   "processes instead of forking for each query (default=on)"));
+
+llvm::cl::opt<unsigned> STPWorkers(
+    "stp-workers", llvm::cl::init(1),
+    llvm::cl::desc("Number of STP worker processes (default=1)"));
 }
 
 #define vc_bvBoolExtract IAMTHESPAWNOFSATAN
@@ -60,14 +75,27 @@ static void stp_error_handler(const char *err_msg) {
 
 namespace klee {
 
+/* the workers are forked from the solver, so they see its configuration */
+static bool workerOptimizeDivides = true;
+
+static SolverImpl::SolverRunStatus
+solveInWorker(const std::string &query,
+              std::vector<std::vector<unsigned char> > &values,
+              bool &hasSolution);
+
 class STPSolverImpl : public SolverImpl {
 private:
   VC vc;
   STPBuilder *builder;
   double timeout;
   bool useForkedSTP;
+  STPWorkerPool *workerPool;
   SolverRunStatus runStatusCode;
 
+  bool computeInitialValuesByWorker(
+      const Query &, const std::vector<const Array *> &objects,
+      std::vector<std::vector<unsigned char> > &values, bool &hasSolution);
+
 public:
   STPSolverImpl(bool _useForkedSTP, bool _optimizeDivides = true);
   ~STPSolverImpl();
@@ -87,7 +115,8 @@ public:
 STPSolverImpl::STPSolverImpl(bool _useForkedSTP, bool _optimizeDivides)
     : vc(vc_createValidityChecker()),
       builder(new STPBuilder(vc, _optimizeDivides)), timeout(0.0),
-      useForkedSTP(_useForkedSTP), runStatusCode(SOLVER_RUN_STATUS_FAILURE) {
+      useForkedSTP(_useForkedSTP), workerPool(0),
+      runStatusCode(SOLVER_RUN_STATUS_FAILURE) {
   assert(vc && "unable to create validity checker");
   assert(builder && "unable to create STPBuilder");
 
@@ -103,7 +132,10 @@ STPSolverImpl::STPSolverImpl(bool _useForkedSTP, bool _optimizeDivides)
 
   vc_registerErrorHandler(::stp_error_handler);
 
-  if (useForkedSTP) {
+  if (useForkedSTP && UseSTPWorkers) {
+    workerOptimizeDivides = _optimizeDivides;
+    workerPool = new STPWorkerPool(STPWorkers, solveInWorker);
+  } else if (useForkedSTP) {
     assert(shared_memory_id == 0 && "shared memory id already allocated");
     shared_memory_id =
         shmget(IPC_PRIVATE, shared_memory_size, IPC_CREAT | 0700);
@@ -118,10 +150,13 @@ STPSolverImpl::STPSolverImpl(bool _useForkedSTP, bool _optimizeDivides)
 
 STPSolverImpl::~STPSolverImpl() {
   // Detach the memory region.
-  shmdt(shared_memory_ptr);
+  if (shared_memory_ptr)
+    shmdt(shared_memory_ptr);
   shared_memory_ptr = 0;
   shared_memory_id = 0;
 
+  delete workerPool;
+
   delete builder;
 
   vc_Destroy(vc);
@@ -212,6 +247,56 @@ runAndGetCex(::VC vc, STPBuilder *builder, ::VCExpr q,
   }
 }
 
+/// Solves a query which was received by an STP worker. The worker uses a
+/// fresh validity checker for each query, so the arrays of the query can be
+/// released after solving it.
+static SolverImpl::SolverRunStatus
+solveInWorker(const std::string &query,
+              std::vector<std::vector<unsigned char> > &values,
+              bool &hasSolution) {
+  llvm::MemoryBuffer *MB = llvm::MemoryBuffer::getMemBuffer(query, "stp-worker");
+  ExprBuilder *exprBuilder = createDefaultExprBuilder();
+  expr::Parser *P = expr::Parser::Create("stp-worker", MB, exprBuilder, false);
+
+  std::vector<expr::Decl *> decls;
+  expr::QueryCommand *qc = 0;
+  while (expr::Decl *D = P->ParseTopLevelDecl()) {
+    decls.push_back(D);
+    if (!qc)
+      qc = dyn_cast<expr::QueryCommand>(D);
+  }
+
+  SolverImpl::SolverRunStatus status = SolverImpl::SOLVER_RUN_STATUS_FAILURE;
+  if (qc && !P->GetNumErrors()) {
+    ::VC vc = vc_createValidityChecker();
+    vc_setInterfaceFlags(vc, EXPRDELETE, 0);
+    make_division_total(vc);
+    vc_registerErrorHandler(::stp_error_handler);
+
+    STPBuilder *builder = new STPBuilder(vc, workerOptimizeDivides);
+    {
+      for (std::vector<ref<Expr> >::const_iterator it = qc->Constraints.begin(),
+                                                   ie = qc->Constraints.end();
+           it != ie; ++it)
+        vc_assertFormula(vc, builder->construct(*it));
+
+      ExprHandle stp_e = builder->construct(qc->Query);
+      status = runAndGetCex(vc, builder, stp_e, qc->Objects, values, hasSolution);
+    }
+    delete builder;
+    vc_Destroy(vc);
+  }
+
+  for (std::vector<expr::Decl *>::iterator it = decls.begin(), ie = decls.end();
+       it != ie; ++it)
+    delete *it;
+  delete P;
+  delete exprBuilder;
+  delete MB;
+
+  return status;
+}
+
 static void stpTimeoutHandler(int x) { _exit(52); }
 
 static SolverImpl::SolverRunStatus
@@ -321,6 +406,35 @@ runAndGetCexForked(::VC vc, STPBuilder *builder, ::VCExpr q,
     }
   }
 }
+
+bool STPSolverImpl::computeInitialValuesByWorker(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<std::vector<unsigned char> > &values, bool &hasSolution) {
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  const Array *const *objectsBegin = objects.empty() ? 0 : &objects[0];
+  ExprPPrinter::printQuery(os, query.constraints, query.expr, 0, 0,
+                           objectsBegin, objectsBegin + objects.size());
+  os.flush();
+
+  if (DebugDumpSTPQueries)
+    klee_warning("STP query:\n%s\n", text.c_str());
+
+  runStatusCode = workerPool->run(text, objects.size(), values, hasSolution,
+                                  timeout);
+  switch (runStatusCode) {
+  case SOLVER_RUN_STATUS_SUCCESS_SOLVABLE:
+  case SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE:
+    return true;
+  case SOLVER_RUN_STATUS_TIMEOUT:
+    return false;
+  default:
+    if (!IgnoreSolverFailures)
+      exit(1);
+    return false;
+  }
+}
+
 bool STPSolverImpl::computeInitialValues(
     const Query &query, const std::vector<const Array *> &objects,
     std::vector<std::vector<unsigned char> > &values, bool &hasSolution) {
@@ -328,6 +442,21 @@ bool STPSolverImpl::computeInitialValues(
 
   TimerStatIncrementer t(stats::queryTime);
 
+  if (workerPool) {
+    ++stats::queries;
+    ++stats::queryCounterexamples;
+
+    bool success = computeInitialValuesByWorker(query, objects, values,
+                                                hasSolution);
+    if (success) {
+      if (hasSolution)
+        ++stats::queriesInvalid;
+      else
+        ++stats::queriesValid;
+    }
+    return success;
+  }
+
   vc_push(vc);
 
   for (ConstraintManager::const_iterator it = query.constraints.begin(),
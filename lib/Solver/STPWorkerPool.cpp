@@ -0,0 +1,278 @@
+//===-- STPWorkerPool.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#include "klee/Config/config.h"
+#ifdef ENABLE_STP
+#include "STPWorkerPool.h"
+
+#include "klee/Internal/Support/ErrorHandling.h"
+#include "klee/Internal/System/Time.h"
+
+#include "llvm/Support/Errno.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+using namespace klee;
+
+#ifdef MSG_NOSIGNAL
+static const int sendFlags = MSG_NOSIGNAL;
+#else
+static const int sendFlags = 0;
+#endif
+
+/* response status codes */
+enum {
+  WORKER_SOLVABLE = 0,
+  WORKER_UNSOLVABLE = 1,
+  WORKER_FAILURE = 2
+};
+
+static bool writeAll(int fd, const void *data, size_t size) {
+  const char *pos = static_cast<const char *>(data);
+  while (size) {
+    ssize_t n = ::send(fd, pos, size, sendFlags);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    pos += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool readAll(int fd, void *data, size_t size) {
+  char *pos = static_cast<char *>(data);
+  while (size) {
+    ssize_t n = ::read(fd, pos, size);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    if (n == 0)
+      return false;
+    pos += n;
+    size -= n;
+  }
+  return true;
+}
+
+static bool writeUInt32(int fd, uint32_t value) {
+  return writeAll(fd, &value, sizeof(value));
+}
+
+static bool readUInt32(int fd, uint32_t &value) {
+  return readAll(fd, &value, sizeof(value));
+}
+
+STPWorkerPool::STPWorkerPool(unsigned size, SolveFn _solve)
+    : next(0), solve(_solve) {
+  Worker worker = { -1, -1 };
+  workers.resize(std::max(1u, size), worker);
+}
+
+STPWorkerPool::~STPWorkerPool() {
+  for (std::vector<Worker>::iterator i = workers.begin(); i != workers.end();
+       i++) {
+    if (i->pid != -1)
+      kill(*i);
+  }
+}
+
+bool STPWorkerPool::spawn(Worker &worker) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+    klee_warning("socketpair failed (for STP worker) - %s",
+                 llvm::sys::StrError(errno).c_str());
+    return false;
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == -1) {
+    klee_warning("fork failed (for STP worker) - %s",
+                 llvm::sys::StrError(errno).c_str());
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return false;
+  }
+
+  if (pid == 0) {
+    /* the timers and the interrupt handler belong to the executor */
+    struct itimerval t = {};
+    ::setitimer(ITIMER_REAL, &t, 0);
+    ::signal(SIGALRM, SIG_IGN);
+    ::signal(SIGINT, SIG_IGN);
+
+    /* otherwise, the other workers would not notice when we close them */
+    for (std::vector<Worker>::iterator i = workers.begin(); i != workers.end();
+         i++) {
+      if (i->pid != -1)
+        ::close(i->fd);
+    }
+    ::close(fds[0]);
+    serve(fds[1]);
+    _exit(0);
+  }
+
+  ::close(fds[1]);
+  worker.pid = pid;
+  worker.fd = fds[0];
+  return true;
+}
+
+void STPWorkerPool::kill(Worker &worker) {
+  ::close(worker.fd);
+  ::kill(worker.pid, SIGKILL);
+
+  int status;
+  pid_t res;
+  do {
+    res = waitpid(worker.pid, &status, 0);
+  } while (res < 0 && errno == EINTR);
+
+  worker.pid = -1;
+  worker.fd = -1;
+}
+
+/// The main loop of a worker, which exits when the socket is closed.
+void STPWorkerPool::serve(int fd) {
+  for (;;) {
+    uint32_t length;
+    if (!readUInt32(fd, length))
+      return;
+
+    std::string query(length, '\0');
+    if (length && !readAll(fd, &query[0], length))
+      return;
+
+    std::vector<std::vector<unsigned char> > values;
+    bool hasSolution = false;
+    SolverImpl::SolverRunStatus status = solve(query, values, hasSolution);
+
+    bool sent;
+    if (status == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE) {
+      sent = writeUInt32(fd, WORKER_SOLVABLE) &&
+             writeUInt32(fd, values.size());
+      for (unsigned i = 0; sent && i < values.size(); i++) {
+        sent = writeUInt32(fd, values[i].size()) &&
+               (values[i].empty() ||
+                writeAll(fd, &values[i][0], values[i].size()));
+      }
+    } else if (status == SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE) {
+      sent = writeUInt32(fd, WORKER_UNSOLVABLE);
+    } else {
+      sent = writeUInt32(fd, WORKER_FAILURE);
+    }
+
+    if (!sent)
+      return;
+  }
+}
+
+SolverImpl::SolverRunStatus
+STPWorkerPool::run(const std::string &query, unsigned objectsCount,
+                   std::vector<std::vector<unsigned char> > &values,
+                   bool &hasSolution, double timeout) {
+  Worker &worker = workers[next];
+  next = (next + 1) % workers.size();
+
+  /* a worker which died since the last query is replaced once */
+  bool sent = false;
+  for (unsigned attempt = 0; attempt < 2 && !sent; attempt++) {
+    if (worker.pid == -1 && !spawn(worker))
+      return SolverImpl::SOLVER_RUN_STATUS_FORK_FAILED;
+
+    sent = writeUInt32(worker.fd, query.size()) &&
+           writeAll(worker.fd, query.data(), query.size());
+    if (!sent)
+      kill(worker);
+  }
+  if (!sent) {
+    klee_warning("unable to send the query to the STP worker");
+    return SolverImpl::SOLVER_RUN_STATUS_INTERRUPTED;
+  }
+
+  /* wait for the response, the executor timers may interrupt us */
+  double deadline = util::getWallTime() + timeout;
+  for (;;) {
+    int remaining = -1;
+    if (timeout) {
+      double left = deadline - util::getWallTime();
+      remaining = left > 0 ? (int)(left * 1000) + 1 : 0;
+    }
+
+    struct pollfd pfd = { worker.fd, POLLIN, 0 };
+    int res = ::poll(&pfd, 1, remaining);
+    if (res > 0)
+      break;
+    if (res == 0) {
+      klee_warning("STP timed out");
+      kill(worker);
+      return SolverImpl::SOLVER_RUN_STATUS_TIMEOUT;
+    }
+    if (errno != EINTR) {
+      klee_warning("poll() for STP worker failed - %s",
+                   llvm::sys::StrError(errno).c_str());
+      kill(worker);
+      return SolverImpl::SOLVER_RUN_STATUS_WAITPID_FAILED;
+    }
+  }
+
+  uint32_t status;
+  if (!readUInt32(worker.fd, status)) {
+    klee_warning("STP worker did not return successfully.  Most likely you "
+                 "forgot to run 'ulimit -s unlimited'");
+    kill(worker);
+    return SolverImpl::SOLVER_RUN_STATUS_INTERRUPTED;
+  }
+
+  if (status == WORKER_UNSOLVABLE) {
+    hasSolution = false;
+    return SolverImpl::SOLVER_RUN_STATUS_SUCCESS_UNSOLVABLE;
+  }
+
+  if (status != WORKER_SOLVABLE) {
+    klee_warning("STP worker failed to solve the query");
+    return SolverImpl::SOLVER_RUN_STATUS_UNEXPECTED_EXIT_CODE;
+  }
+
+  uint32_t count;
+  bool received = readUInt32(worker.fd, count) && count == objectsCount;
+  values = std::vector<std::vector<unsigned char> >(objectsCount);
+  for (unsigned i = 0; received && i < count; i++) {
+    uint32_t size;
+    received = readUInt32(worker.fd, size);
+    if (received && size) {
+      values[i].resize(size);
+      received = readAll(worker.fd, &values[i][0], size);
+    }
+  }
+
+  if (!received) {
+    klee_warning("STP worker returned a malformed counterexample");
+    kill(worker);
+    return SolverImpl::SOLVER_RUN_STATUS_UNEXPECTED_EXIT_CODE;
+  }
+
+  hasSolution = true;
+  return SolverImpl::SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+}
+#endif // ENABLE_STP
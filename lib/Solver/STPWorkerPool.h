@@ -0,0 +1,61 @@
+//===-- STPWorkerPool.h -----------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_STPWORKERPOOL_H
+#define KLEE_STPWORKERPOOL_H
+
+#include "klee/SolverImpl.h"
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace klee {
+  /// STPWorkerPool - A pool of long-lived STP processes. Each query is sent
+  /// to a worker in the KQuery format over a socket pair, and the worker
+  /// answers with the counterexample (of any size) on the same socket. A worker
+  /// which exceeds the timeout is killed, and a new one is forked on the
+  /// next query.
+  class STPWorkerPool {
+  public:
+    /// The function which solves a single query in the worker process.
+    typedef SolverImpl::SolverRunStatus (*SolveFn)(
+        const std::string &query,
+        std::vector<std::vector<unsigned char> > &values, bool &hasSolution);
+
+  private:
+    struct Worker {
+      pid_t pid;
+      /// Our end of the socket pair, the worker holds the other one.
+      int fd;
+    };
+
+    std::vector<Worker> workers;
+    unsigned next;
+    SolveFn solve;
+
+    bool spawn(Worker &worker);
+    void kill(Worker &worker);
+    void serve(int fd);
+
+  public:
+    STPWorkerPool(unsigned size, SolveFn solve);
+    ~STPWorkerPool();
+
+    /// Checks the validity of the query given in the KQuery format, and
+    /// computes the initial values of the objects (in the order in which
+    /// they were printed) if it is not valid.
+    SolverImpl::SolverRunStatus
+    run(const std::string &query, unsigned objectsCount,
+        std::vector<std::vector<unsigned char> > &values, bool &hasSolution,
+        double timeout);
+  };
+}
+
+#endif
@@ -15,6 +15,7 @@
 #include "klee/util/Bits.h"
 #include "ConstantDivision.h"
 #include "klee/SolverStats.h"
+#include "klee/CommandLine.h"
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
@@ -391,6 +392,30 @@ Z3ASTHandle Z3Builder::getInitialRead(const Array *root, unsigned index) {
   return readExpr(getInitialArray(root), bvConst32(32, index));
 }
 
+const ConstantArrayRuns &Z3Builder::getLookupTable(const Array *root) {
+  std::map<const Array *, ConstantArrayRuns>::iterator it =
+    lookupTables.find(root);
+  if (it != lookupTables.end())
+    return it->second;
+
+  ConstantArrayRuns &runs = lookupTables[root];
+  getConstantArrayRuns(root, LookupTableMaxRuns, runs);
+  return runs;
+}
+
+/// Builds a binary search over the runs [begin, end) of a constant array.
+Z3ASTHandle Z3Builder::constructLookup(const ConstantArrayRuns &runs,
+                                       Z3ASTHandle index, unsigned indexWidth,
+                                       unsigned begin, unsigned end) {
+  if (end - begin == 1)
+    return construct(runs[begin].second, 0);
+
+  unsigned mid = begin + (end - begin) / 2;
+  return iteExpr(bvLtExpr(index, bvConst32(indexWidth, runs[mid].first)),
+                 constructLookup(runs, index, indexWidth, begin, mid),
+                 constructLookup(runs, index, indexWidth, mid, end));
+}
+
 Z3ASTHandle Z3Builder::getArrayForUpdate(const Array *root,
                                          const UpdateNode *un) {
   if (!un) {
@@ -484,6 +509,18 @@ Z3ASTHandle Z3Builder::constructActual(ref<Expr> e, int *width_out) {
     ReadExpr *re = cast<ReadExpr>(e);
     assert(re && re->updates.root);
     *width_out = re->updates.root->getRange();
+
+    // lookup tables are encoded without an array
+    if (!re->updates.head && re->updates.root->isConstantArray() &&
+        LookupTableMaxRuns) {
+      const ConstantArrayRuns &runs = getLookupTable(re->updates.root);
+      if (!runs.empty()) {
+        ++stats::queryLookupTables;
+        return constructLookup(runs, construct(re->index, 0),
+                               re->updates.root->getDomain(), 0, runs.size());
+      }
+    }
+
     return readExpr(getArrayForUpdate(re->updates.root, re->updates.head),
                     construct(re->index, 0));
   }
@@ -12,7 +12,9 @@
 
 #include "klee/util/ExprHashMap.h"
 #include "klee/util/ArrayExprHash.h"
+#include "klee/util/ExprUtil.h"
 #include "klee/Config/config.h"
+#include <map>
 #include <z3.h>
 
 namespace klee {
@@ -109,6 +111,10 @@ class Z3Builder {
   ExprHashMap<std::pair<Z3ASTHandle, unsigned> > constructed;
   Z3ArrayExprHash _arr_hash;
 
+  /// The runs of the constant arrays read at symbolic indices, empty if an
+  /// array has too many runs (see -lookup-table-max-runs).
+  std::map<const Array *, ConstantArrayRuns> lookupTables;
+
 private:
   Z3ASTHandle bvOne(unsigned width);
   Z3ASTHandle bvZero(unsigned width);
@@ -162,6 +168,11 @@ private:
   Z3ASTHandle getInitialArray(const Array *os);
   Z3ASTHandle getArrayForUpdate(const Array *root, const UpdateNode *un);
 
+  const ConstantArrayRuns &getLookupTable(const Array *root);
+  Z3ASTHandle constructLookup(const ConstantArrayRuns &runs,
+                              Z3ASTHandle index, unsigned indexWidth,
+                              unsigned begin, unsigned end);
+
   Z3ASTHandle constructActual(ref<Expr> e, int *width_out);
   Z3ASTHandle construct(ref<Expr> e, int *width_out);
 
@@ -15,6 +15,10 @@
 #include "gperftools/malloc_extension.h"
 #endif
 
+#ifdef HAVE_JEMALLOC_JEMALLOC_H
+#include <jemalloc/jemalloc.h>
+#endif
+
 #ifdef HAVE_MALLINFO
 #include <malloc.h>
 #endif
@@ -95,6 +99,17 @@ size_t util::GetTotalMallocUsage() {
   MallocExtension::instance()->GetNumericProperty(
       "generic.current_allocated_bytes", &value);
   return value;
+#elif defined(HAVE_JEMALLOC_JEMALLOC_H)
+  // The statistics of jemalloc are snapshots, which are refreshed by
+  // advancing the epoch.
+  uint64_t epoch = 1;
+  size_t size = sizeof(epoch);
+  mallctl("epoch", &epoch, &size, &epoch, size);
+
+  size_t value = 0;
+  size = sizeof(value);
+  mallctl("stats.allocated", &value, &size, NULL, 0);
+  return value;
 #elif HAVE_MALLINFO
   struct mallinfo mi = ::mallinfo();
   // The malloc implementation in glibc (pmalloc2)
@@ -120,3 +135,12 @@ size_t util::GetTotalMallocUsage() {
 
 #endif
 }
+
+bool util::IsMallocUsageCheap() {
+#if defined(KLEE_ASAN_BUILD) || defined(HAVE_GPERFTOOLS_MALLOC_EXTENSION_H) || \
+    defined(HAVE_JEMALLOC_JEMALLOC_H)
+  return true;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,166 @@
+//===-- PerfCounters.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/System/PerfCounters.h"
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#include "llvm/Support/Errno.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace klee;
+
+bool perf::enabled = false;
+
+namespace {
+
+const char *phaseNames[perf::NumPhases] = {
+  "Interpreter", "Solver", "Fork", "Recovery", "Searcher"
+};
+
+const char *counterNames[perf::NumCounters] = {
+  "Cycles", "Instructions", "LLCMisses", "BranchMisses"
+};
+
+perf::Phase currentPhase = perf::Interpreter;
+uint64_t totals[perf::NumPhases][perf::NumCounters];
+uint64_t last[perf::NumCounters];
+
+/* the opened counters, and the counter read from each of them */
+int fds[perf::NumCounters];
+perf::Counter positions[perf::NumCounters];
+unsigned opened = 0;
+
+#ifdef __linux__
+/* The counters are inherited by the child processes, so that the forked
+   core solver (-use-forked-solver) and the external SMT-LIB solvers are
+   counted in the phase which waits for them: the counts of a child are
+   added to the parent's counter when the child exits, which is before
+   waitpid returns. The kernel does not support group reads of inherited
+   counters, so each counter is read on its own. */
+int openCounter(uint64_t config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/// Reads the current values of all counters.
+bool readCounters(uint64_t values[perf::NumCounters]) {
+  memset(values, 0, perf::NumCounters * sizeof(uint64_t));
+  for (unsigned i = 0; i < opened; i++) {
+    uint64_t value;
+    if (::read(fds[i], &value, sizeof(value)) != sizeof(value))
+      return false;
+    values[positions[i]] = value;
+  }
+  return true;
+}
+
+}
+
+bool perf::start() {
+#ifdef __linux__
+  static const uint64_t configs[NumCounters] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  /* a counter which the CPU (or the hypervisor) does not provide is
+     reported as zero */
+  for (unsigned i = 0; i < NumCounters; i++) {
+    int fd = openCounter(configs[i]);
+    if (fd < 0) {
+      klee_warning("perf counter %s is not available - %s", counterNames[i],
+                   llvm::sys::StrError(errno).c_str());
+      continue;
+    }
+    fds[opened] = fd;
+    positions[opened] = (Counter)i;
+    opened++;
+  }
+
+  if (!opened) {
+    klee_warning("perf counters are disabled (see "
+                 "/proc/sys/kernel/perf_event_paranoid)");
+    return false;
+  }
+
+  memset(totals, 0, sizeof(totals));
+  for (unsigned i = 0; i < opened; i++) {
+    ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+  if (!readCounters(last)) {
+    klee_warning("unable to read the perf counters");
+    stop();
+    return false;
+  }
+
+  currentPhase = Interpreter;
+  enabled = true;
+  return true;
+#else
+  klee_warning("perf counters are only supported on Linux");
+  return false;
+#endif
+}
+
+void perf::stop() {
+  if (enabled)
+    update();
+  enabled = false;
+
+  for (unsigned i = 0; i < opened; i++)
+    ::close(fds[i]);
+  opened = 0;
+}
+
+perf::Phase perf::enter(Phase phase) {
+  update();
+  Phase previous = currentPhase;
+  currentPhase = phase;
+  return previous;
+}
+
+void perf::update() {
+  uint64_t values[NumCounters];
+  if (!readCounters(values))
+    return;
+
+  for (unsigned i = 0; i < NumCounters; i++) {
+    totals[currentPhase][i] += values[i] - last[i];
+    last[i] = values[i];
+  }
+}
+
+uint64_t perf::getValue(Phase phase, Counter counter) {
+  return totals[phase][counter];
+}
+
+const char *perf::getPhaseName(Phase phase) { return phaseNames[phase]; }
+
+const char *perf::getCounterName(Counter counter) {
+  return counterNames[counter];
+}
@@ -0,0 +1,202 @@
+//===-- PhaseTrace.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/Support/PhaseTrace.h"
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace klee;
+
+bool trace::enabled = false;
+
+namespace {
+
+/// A complete ('X') event: a phase is recorded once it ends, so that a
+/// full buffer drops whole phases and never unbalances the trace.
+struct Event {
+  /// Microseconds since the trace was opened.
+  uint64_t timestamp;
+  uint64_t duration;
+  const void *state;
+  int level;
+  trace::Phase phase;
+};
+
+const char *phaseNames[trace::NumPhases] = {
+  "interpret", "recovery", "solver", "fork", "slicing", "test generation",
+  "stats"
+};
+
+/* must be a power of two */
+const uint64_t kBufferSize = 1 << 16;
+
+/* how often (in milliseconds) the writer drains the buffer */
+const unsigned kFlushInterval = 50;
+
+/// A single-producer, single-consumer ring buffer: the interpreter thread
+/// advances head, and the writer thread advances tail.
+Event buffer[kBufferSize];
+std::atomic<uint64_t> head(0);
+std::atomic<uint64_t> tail(0);
+std::atomic<bool> stopped(false);
+uint64_t dropped = 0;
+
+/// The phases which have begun but not ended yet (interpreter thread only).
+std::vector<Event> openPhases;
+
+FILE *traceFile = 0;
+bool firstEvent = true;
+std::thread writer;
+std::chrono::steady_clock::time_point startTime;
+
+void writeEvent(const Event &e) {
+  fprintf(traceFile, "%s\n{\"name\": \"%s\", \"cat\": \"klee\", \"ph\": \"X\", "
+                     "\"ts\": %llu, \"dur\": %llu, \"pid\": %d, \"tid\": 0",
+          firstEvent ? "" : ",", phaseNames[e.phase],
+          (unsigned long long)e.timestamp, (unsigned long long)e.duration,
+          (int)getpid());
+  firstEvent = false;
+
+  if (e.state) {
+    fprintf(traceFile, ", \"args\": {\"state\": \"%p\"", e.state);
+    if (e.level >= 0)
+      fprintf(traceFile, ", \"level\": %d", e.level);
+    fprintf(traceFile, "}");
+  }
+  fprintf(traceFile, "}");
+}
+
+void drain() {
+  uint64_t t = tail.load(std::memory_order_relaxed);
+  uint64_t h = head.load(std::memory_order_acquire);
+  for (; t != h; t++)
+    writeEvent(buffer[t & (kBufferSize - 1)]);
+  tail.store(t, std::memory_order_release);
+  fflush(traceFile);
+}
+
+void runWriter() {
+  while (!stopped.load()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kFlushInterval));
+    drain();
+  }
+}
+
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - startTime).count();
+}
+
+void record(const Event &event) {
+  uint64_t h = head.load(std::memory_order_relaxed);
+  if (h - tail.load(std::memory_order_acquire) >= kBufferSize) {
+    /* the writer is behind, which is reported at the end */
+    dropped++;
+    return;
+  }
+
+  buffer[h & (kBufferSize - 1)] = event;
+  head.store(h + 1, std::memory_order_release);
+}
+
+/* klee_error and -exit-on-error leave by exit(), the writer must be joined
+   before the static destructors run and the trace must still be closed */
+void closeAtExit() {
+  trace::close();
+}
+
+}
+
+bool trace::open(const std::string &path) {
+  traceFile = fopen(path.c_str(), "w");
+  if (!traceFile) {
+    klee_warning("unable to open the trace file %s", path.c_str());
+    return false;
+  }
+
+  fprintf(traceFile, "[");
+  startTime = std::chrono::steady_clock::now();
+
+  static bool registered = false;
+  if (!registered) {
+    registered = true;
+    atexit(closeAtExit);
+  }
+
+  /* the executor timers must be delivered to the interpreter thread */
+  sigset_t blocked, old;
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGALRM);
+  sigaddset(&blocked, SIGINT);
+  pthread_sigmask(SIG_BLOCK, &blocked, &old);
+  writer = std::thread(runWriter);
+  pthread_sigmask(SIG_SETMASK, &old, 0);
+
+  enabled = true;
+  return true;
+}
+
+void trace::close() {
+  if (!traceFile)
+    return;
+
+  enabled = false;
+  stopped = true;
+  writer.join();
+  drain();
+
+  /* the phases which are still open end now, e.g. on exit() */
+  while (!openPhases.empty()) {
+    Event e = openPhases.back();
+    openPhases.pop_back();
+    e.duration = now() - e.timestamp;
+    record(e);
+  }
+  drain();
+  fprintf(traceFile, "\n]\n");
+  fclose(traceFile);
+  traceFile = 0;
+
+  if (dropped)
+    klee_warning("%llu trace phases were dropped (the trace is incomplete)",
+                 (unsigned long long)dropped);
+}
+
+void trace::begin(Phase phase, const void *state, int level) {
+  Event e;
+  e.timestamp = now();
+  e.duration = 0;
+  e.state = state;
+  e.level = level;
+  e.phase = phase;
+  openPhases.push_back(e);
+}
+
+void trace::end(Phase phase) {
+  /* the trace was closed while the phase was open */
+  if (!traceFile)
+    return;
+
+  assert(!openPhases.empty() && openPhases.back().phase == phase &&
+         "unbalanced trace phases");
+  Event e = openPhases.back();
+  openPhases.pop_back();
+  e.duration = now() - e.timestamp;
+  record(e);
+}
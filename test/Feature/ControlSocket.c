@@ -0,0 +1,36 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: /bin/sh -c "%klee --output-dir=%t.klee-out -control-socket %t.bc > %t.log 2>&1 & i=0; while [ ! -S %t.klee-out/control.sock ] && [ $i -lt 300 ]; do sleep 0.1; i=$((i+1)); done"
+//
+// A client which never completes its command must not hold up the others.
+// RUN: /bin/sh -c "python -c 'import socket, sys, time; s = socket.socket(socket.AF_UNIX); s.connect(sys.argv[1]); s.send(b\"st\"); time.sleep(5)' %t.klee-out/control.sock > /dev/null 2>&1 &"
+//
+// RUN: %klee-control --stats %t.klee-out > %t.stats
+// RUN: python -c 'import json, sys; json.load(open(sys.argv[1]))' %t.stats
+// RUN: FileCheck %s -check-prefix=CHECK-STATS -input-file=%t.stats
+// RUN: %klee-control --halt-execution %t.klee-out | FileCheck %s -check-prefix=CHECK-HALT
+// RUN: /bin/sh -c "i=0; while ! grep -q 'KLEE: done' %t.log && [ $i -lt 300 ]; do sleep 0.1; i=$((i+1)); done"
+// RUN: FileCheck %s -input-file=%t.log
+
+// CHECK-STATS: "instructions":
+// CHECK-STATS: "states": {"normal": 1, "suspended": 0, "recovery": 0}
+// CHECK-STATS: "queries":
+// CHECK-STATS: "halted": false
+
+// CHECK-HALT: ok
+
+// CHECK: KLEE: control socket:
+// CHECK: halting execution (requested on the control socket)
+// CHECK: KLEE: done
+
+#include <klee/klee.h>
+
+int main() {
+  volatile unsigned i = 0;
+
+  /* runs until it is halted */
+  while (1)
+    i++;
+
+  return 0;
+}
@@ -0,0 +1,38 @@
+// RUN: %llvmgcc %s -g -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -search=nurs:directed -max-instructions=5000 -exit-on-error-type Assert -error-location=DirectedSearch.c:33 %t1.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -search=dfs -max-instructions=5000 %t1.bc 2>&1 | FileCheck -check-prefix=CHECK-BOUNDED %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -search=bfs -max-instructions=5000 %t1.bc 2>&1 | FileCheck -check-prefix=CHECK-BOUNDED %s
+
+// Each branch leads to a long loop on one side, and the two branches have
+// opposite polarities, so both DFS and BFS spend the instruction budget in
+// a loop before reaching the assertion, while the directed searcher heads
+// for it.
+
+// CHECK: directed search: {{[1-9][0-9]*}} target instructions
+// CHECK: ASSERTION FAIL
+// CHECK-BOUNDED-NOT: ASSERTION FAIL
+// CHECK-BOUNDED: KLEE: done
+
+#include <assert.h>
+#include <klee/klee.h>
+
+void spin(int n) {
+  while (n--) { }
+}
+
+int main() {
+  char buf[2];
+  klee_make_symbolic(buf, sizeof buf, "buf");
+  if (buf[0] == 'a') {
+    if (buf[1] != 'b')
+      spin(2000);
+    else
+      assert(0);
+  } else {
+    spin(2000);
+  }
+  return 0;
+}
@@ -0,0 +1,28 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t1.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -lookup-table-max-runs=0 %t1.bc 2>&1 | FileCheck %s
+// CHECK-NOT: ASSERTION FAIL
+// CHECK: KLEE: done: completed paths = 3
+
+#include <klee/klee.h>
+
+/* five runs of equal values */
+static const unsigned char table[64] = { [10] = 1, [11] = 1, [12] = 1,
+                                         [40] = 2 };
+
+int main() {
+  unsigned char i;
+  klee_make_symbolic(&i, sizeof(i), "i");
+  klee_assume(i < 64);
+
+  unsigned char v = table[i];
+  if (v == 2)
+    klee_assert(i == 40);
+  else if (v == 1)
+    klee_assert(i >= 10 && i <= 12);
+  else
+    klee_assert(i != 40 && (i < 10 || i > 12));
+  return 0;
+}
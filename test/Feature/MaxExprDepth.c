@@ -0,0 +1,19 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -max-expr-depth=32 %t1.bc 2>&1 | FileCheck %s
+// CHECK: silently concretizing (reason: expression complexity limit)
+// CHECK: KLEE: done: completed paths = 1
+
+#include <klee/klee.h>
+
+int main() {
+  unsigned char buf[64];
+  klee_make_symbolic(buf, sizeof(buf), "buf");
+
+  /* the checksum is concretized once it is too deep */
+  unsigned sum = 0;
+  for (unsigned i = 0; i < sizeof(buf); i++)
+    sum = (sum << 1) ^ buf[i];
+
+  return sum & 1;
+}
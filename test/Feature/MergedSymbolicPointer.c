@@ -0,0 +1,24 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -max-merged-resolutions=4 %t1.bc 2>&1 | FileCheck %s
+// CHECK-NOT: ASSERTION FAIL
+// CHECK: KLEE: done: completed paths = 1
+
+#include <klee/klee.h>
+
+int a[4] = { 1 }, b[4] = { 2 }, c[4] = { 3 };
+int *targets[3] = { a, b, c };
+
+int main() {
+  unsigned i;
+  klee_make_symbolic(&i, sizeof(i), "i");
+  klee_assume(i < 3);
+
+  /* the pointer resolves to the three arrays */
+  int *p = targets[i];
+  klee_assert(*p == i + 1);
+
+  *p = 0;
+  klee_assert(a[0] + b[0] + c[0] == 5 - i);
+  return 0;
+}
@@ -0,0 +1,23 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -native-string-functions %t1.bc 2>&1 | FileCheck %s
+// CHECK-NOT: ASSERTION FAIL
+// CHECK: KLEE: done: completed paths = 2
+
+#include <klee/klee.h>
+#include <string.h>
+
+int main() {
+  char buf[8];
+  klee_make_symbolic(buf, sizeof(buf), "buf");
+  buf[7] = 0;
+
+  /* neither call forks on the bytes of buf */
+  size_t n = strlen(buf);
+  klee_assert(n < 8);
+  klee_assert(strcmp(buf, buf) == 0);
+
+  if (n > 3)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,17 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.cache %t.klee-out %t.klee-out2
+// RUN: %klee --output-dir=%t.klee-out -prepared-module-cache=%t.cache %t1.bc 2>&1 | FileCheck -check-prefix=CHECK-FIRST %s
+// RUN: %klee --output-dir=%t.klee-out2 -prepared-module-cache=%t.cache %t1.bc 2>&1 | FileCheck -check-prefix=CHECK-SECOND %s
+// RUN: test -f %t.klee-out2/test000002.ktest
+// CHECK-FIRST-NOT: Using the prepared module
+// CHECK-SECOND: Using the prepared module
+
+#include <klee/klee.h>
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (x > 10)
+    return 1;
+  return 0;
+}
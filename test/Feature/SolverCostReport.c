@@ -0,0 +1,20 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -solver-cost-report %t1.bc
+// RUN: FileCheck %s --input-file=%t.klee-out/solver-costs.txt
+// CHECK: [origin]
+// CHECK: branch: 1
+// CHECK: [level]
+// CHECK: normal:
+// CHECK: [line]
+// CHECK: SolverCostReport.c:{{[0-9]+}} main
+
+#include <klee/klee.h>
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (x > 10)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,35 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t1.bc
+// RUN: %opt -mem2reg %t1.bc -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t1.bc 2>&1 | FileCheck %s -check-prefix=CHECK-PATHS
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --specialize-functions %t1.bc 2>&1 | FileCheck %s -check-prefix=CHECK-SPEC -check-prefix=CHECK-PATHS
+// RUN: FileCheck %s -input-file=%t.klee-out/assembly.ll -check-prefix=CHECK-CLONE
+
+// The concrete mode never forks, so the specialized run explores the same
+// paths; the clone just no longer branches on it.
+// CHECK-SPEC: specialized 1 functions
+// CHECK-PATHS: KLEE: done: completed paths = 2
+
+// CHECK-CLONE: define internal i32 @scale.specialized
+// CHECK-CLONE-NOT: icmp
+// CHECK-CLONE: mul
+// CHECK-CLONE-NOT: icmp
+// CHECK-CLONE: }
+
+#include <klee/klee.h>
+
+int scale(int x, int mode) {
+  if (mode == 0)
+    return x;
+  if (mode == 1)
+    return x * 2;
+  return x * 3;
+}
+
+int main() {
+  int x = klee_int("x");
+  if (scale(x, 1) > 10)
+    return 1;
+  return scale(x, 1) - 1;
+}
@@ -0,0 +1,20 @@
+// RUN: %llvmgcc %s -emit-llvm -g -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -stats-thread -search=nurs:md2u -uncovered-update-interval=0.01 -istats-write-interval=0.01 -stats-write-interval=0.01 %t1.bc
+// RUN: FileCheck -check-prefix=CHECK-STATS --input-file=%t.klee-out/run.stats %s
+// RUN: FileCheck -check-prefix=CHECK-ISTATS --input-file=%t.klee-out/run.istats %s
+// CHECK-STATS: ('Instructions',
+// CHECK-STATS: ({{[0-9]+}},
+// CHECK-ISTATS: positions: instr line
+// CHECK-ISTATS: fn=main
+
+#include <klee/klee.h>
+
+int main() {
+  int x, i, n = 0;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  for (i = 0; i < 1000; i++)
+    if (x > i)
+      n++;
+  return n;
+}
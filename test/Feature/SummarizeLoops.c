@@ -0,0 +1,23 @@
+// RUN: %llvmgcc %s -emit-llvm -O1 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -summarize-loops %t1.bc 2>&1 | FileCheck %s
+// CHECK: KLEE: summarized {{[1-9][0-9]*}} scanning loops
+// CHECK-NOT: ASSERTION FAIL
+// the guard of the rotated loop may fork once
+// CHECK: KLEE: done: completed paths = {{[12]$}}
+
+#include <klee/klee.h>
+
+int main() {
+  char buf[16];
+  klee_make_symbolic(buf, sizeof(buf), "buf");
+  buf[15] = ',';
+
+  /* scanning for the delimiter does not fork */
+  char *p = buf;
+  while (*p != ',')
+    p++;
+  klee_assert(*p == ',' && p - buf < 16);
+
+  return p - buf;
+}
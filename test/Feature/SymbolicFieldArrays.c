@@ -0,0 +1,25 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -symbolic-field-arrays --write-kqueries %t1.bc 2>&1 | FileCheck %s
+// RUN: cat %t.klee-out/test000001.kquery %t.klee-out/test000002.kquery > %t.kquery
+// RUN: FileCheck -check-prefix=CHECK-ARRAYS %s < %t.kquery
+// CHECK: KLEE: done: completed paths = 2
+// CHECK-ARRAYS: array s_4[4]
+// CHECK-ARRAYS-NOT: array s[
+
+#include <klee/klee.h>
+
+struct pair {
+  int a;
+  int b;
+};
+
+int main() {
+  struct pair s;
+  klee_make_symbolic(&s, sizeof(s), "s");
+
+  /* only the array of s.b is involved */
+  if (s.b > 0)
+    return 1;
+  return 0;
+}
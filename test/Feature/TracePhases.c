@@ -0,0 +1,30 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out -trace-phases %t1.bc
+// RUN: FileCheck %s --input-file=%t.klee-out/trace.json
+// RUN: rm -rf %t.klee-out-exit
+// RUN: not %klee --output-dir=%t.klee-out-exit -trace-phases -exit-on-error %t1.bc
+// RUN: python -c 'import json, sys; json.load(open(sys.argv[1]))' %t.klee-out-exit/trace.json
+// RUN: FileCheck %s --input-file=%t.klee-out-exit/trace.json -check-prefix=CHECK-EXIT
+// CHECK: [
+// CHECK-DAG: "name": "interpret", "cat": "klee", "ph": "X"
+// CHECK-DAG: "name": "solver", "cat": "klee", "ph": "X"
+// CHECK-DAG: "name": "fork", "cat": "klee", "ph": "X"
+// CHECK-DAG: "name": "test generation", "cat": "klee", "ph": "X"
+// CHECK: ]
+
+// The phases which are open when klee exits on the error are closed.
+// CHECK-EXIT-DAG: "name": "interpret", "cat": "klee", "ph": "X"
+// CHECK-EXIT-DAG: "name": "test generation", "cat": "klee", "ph": "X"
+
+#include <klee/klee.h>
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (x > 10)
+    return 1;
+  if (x == 5)
+    klee_report_error(__FILE__, __LINE__, "reached", "user.err");
+  return 0;
+}
@@ -0,0 +1,21 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-independent-solver=false %t1.bc
+// RUN: ktest-tool --write-ints %t.klee-out/test000001.ktest | FileCheck %s
+
+// The objects which are not constrained are not solved for, and get zero
+// bytes even without the independent solver.
+
+int main() {
+  int x, y;
+
+  klee_make_symbolic(&x, sizeof x, "x");
+  klee_make_symbolic(&y, sizeof y, "y");
+  klee_assume(x == 42);
+
+  // CHECK: object    0: name: {{b*}}'x'
+  // CHECK: object    0: data: 42
+  // CHECK: object    1: name: {{b*}}'y'
+  // CHECK: object    1: data: 0
+  return 0;
+}
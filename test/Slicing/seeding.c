@@ -0,0 +1,57 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t.bc "initial"
+// RUN: test -f %t.klee-out/test000001.ktest
+// RUN: not test -f %t.klee-out/test000002.ktest
+// RUN: rm -rf %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-2 -skip-functions=f -seed-recovery-states --only-replay-seeds --only-seed --seed-out %t.klee-out/test000001.ktest %t.bc > %t.out 2>&1
+// RUN: FileCheck %s -input-file=%t.out
+// RUN: rm -rf %t.klee-out-3
+// RUN: %klee --output-dir=%t.klee-out-3 -skip-functions=f --only-replay-seeds --only-seed --seed-out %t.klee-out/test000001.ktest %t.bc > %t.unseeded.out 2>&1
+// RUN: FileCheck %s -input-file=%t.unseeded.out -check-prefix=CHECK-UNSEEDED
+
+// The seeded state is suspended at the load of o, so its recovery state has
+// to follow the seed (x == 5) for the seeded path to be completed.
+
+// CHECK-NOT: o is 1
+// CHECK: o is 2
+// CHECK-NOT: o is 1
+// CHECK: KLEE: done: recovery states = 1
+
+// Without -seed-recovery-states, the recovery state is not seeded, so it
+// does not run during seeding and o is never recovered.
+
+// CHECK-UNSEEDED-NOT: o is 2
+// CHECK-UNSEEDED-NOT: dropping their seeds
+// CHECK-UNSEEDED: KLEE: done
+
+#include <stdio.h>
+
+#include <klee/klee.h>
+
+void f(int *o, int x) {
+    if (x > 10) {
+        *o = 1;
+    } else {
+        *o = 2;
+    }
+}
+
+int main(int argc, char *argv[], char *envp[]) {
+    int o = 0;
+    int x;
+
+    klee_make_symbolic(&x, sizeof(x), "x");
+    if (argc == 2) {
+        klee_assume(x == 5);
+    }
+
+    f(&o, x);
+    if (o == 2) {
+        printf("o is 2\n");
+    } else {
+        printf("o is 1\n");
+    }
+
+    return 0;
+}
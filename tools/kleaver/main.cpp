@@ -22,6 +22,7 @@
 #include "klee/util/ExprPPrinter.h"
 #include "klee/util/ExprVisitor.h"
 #include "klee/util/ExprSMTLIBPrinter.h"
+#include "klee/util/ExprSerializer.h"
 #include "klee/Internal/Support/PrintVersion.h"
 
 #include "llvm/ADT/StringExtras.h"
@@ -31,8 +32,13 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
 
 #include "llvm/Support/Signals.h"
 
@@ -54,6 +60,7 @@ namespace {
     PrintTokens,
     PrintAST,
     PrintSMTLIBv2,
+    WriteBinary,
     Evaluate
   };
 
@@ -67,6 +74,9 @@ namespace {
 					   "Print parsed input file as SMT-LIBv2 query."),
              clEnumValN(PrintAST, "print-ast",
                         "Print parsed AST nodes from the input file."),
+             clEnumValN(WriteBinary, "write-binary",
+                        "Write the queries of the input file in the binary "
+                        "format to stdout."),
              clEnumValN(Evaluate, "evaluate",
                         "Print parsed AST nodes from the input file."),
              clEnumValEnd));
@@ -100,6 +110,14 @@ namespace {
       llvm::cl::desc("We discard the previous array declarations after a query "
                      "is performed. Default: false"),
       llvm::cl::init(false));
+
+  llvm::cl::opt<unsigned> InputParts(
+      "split-input",
+      llvm::cl::desc("Split the input at query boundaries into this many "
+                     "parts, which are evaluated in parallel. Every query "
+                     "must be preceded by the declarations of its arrays "
+                     "(default=1)"),
+      llvm::cl::init(1));
 }
 
 static std::string getQueryLogPath(const char filename[])
@@ -164,7 +182,6 @@ static void PrintInputTokens(const MemoryBuffer *MB) {
 static bool PrintInputAST(const char *Filename,
                           const MemoryBuffer *MB,
                           ExprBuilder *Builder) {
-  std::vector<Decl*> Decls;
   Parser *P = Parser::Create(Filename, MB, Builder, ClearArrayAfterQuery);
   P->SetMaxErrors(20);
 
@@ -176,7 +193,7 @@ static bool PrintInputAST(const char *Filename,
 
       D->dump();
     }
-    Decls.push_back(D);
+    delete D;
   }
 
   bool success = true;
@@ -185,34 +202,45 @@ static bool PrintInputAST(const char *Filename,
     success = false;
   }
 
-  for (std::vector<Decl*>::iterator it = Decls.begin(),
-         ie = Decls.end(); it != ie; ++it)
-    delete *it;
-
   delete P;
 
   return success;
 }
 
-static bool EvaluateInputAST(const char *Filename,
+static bool WriteInputBinary(const char *Filename,
                              const MemoryBuffer *MB,
                              ExprBuilder *Builder) {
   std::vector<Decl*> Decls;
   Parser *P = Parser::Create(Filename, MB, Builder, ClearArrayAfterQuery);
   P->SetMaxErrors(20);
-  while (Decl *D = P->ParseTopLevelDecl()) {
+  while (Decl *D = P->ParseTopLevelDecl())
     Decls.push_back(D);
-  }
 
   bool success = true;
   if (unsigned N = P->GetNumErrors()) {
     llvm::errs() << Filename << ": parse failure: " << N << " errors.\n";
     success = false;
-  }  
+  }
 
-  if (!success)
-    return false;
+  if (success) {
+    ExprSerializer serializer(llvm::outs());
+    for (std::vector<Decl*>::iterator it = Decls.begin(),
+           ie = Decls.end(); it != ie; ++it)
+      if (QueryCommand *QC = dyn_cast<QueryCommand>(*it))
+        serializer.writeQuery(QC->Constraints, QC->Query, QC->Values,
+                              QC->Objects);
+  }
 
+  for (std::vector<Decl*>::iterator it = Decls.begin(),
+         ie = Decls.end(); it != ie; ++it)
+    delete *it;
+
+  delete P;
+
+  return success;
+}
+
+static Solver *createSolverChain(const std::string &LogSuffix) {
   Solver *coreSolver = klee::createCoreSolver(CoreSolverToUse);
 
   if (CoreSolverToUse != DUMMY_SOLVER) {
@@ -221,93 +249,249 @@ static bool EvaluateInputAST(const char *Filename,
     }
   }
 
-  Solver *S = constructSolverChain(coreSolver,
-                                   getQueryLogPath(ALL_QUERIES_SMT2_FILE_NAME),
-                                   getQueryLogPath(SOLVER_QUERIES_SMT2_FILE_NAME),
-                                   getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME),
-                                   getQueryLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME));
+  return constructSolverChain(
+      coreSolver,
+      getQueryLogPath(ALL_QUERIES_SMT2_FILE_NAME) + LogSuffix,
+      getQueryLogPath(SOLVER_QUERIES_SMT2_FILE_NAME) + LogSuffix,
+      getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME) + LogSuffix,
+      getQueryLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME) + LogSuffix);
+}
 
-  unsigned Index = 0;
-  for (std::vector<Decl*>::iterator it = Decls.begin(),
-         ie = Decls.end(); it != ie; ++it) {
-    Decl *D = *it;
-    if (QueryCommand *QC = dyn_cast<QueryCommand>(D)) {
-      llvm::outs() << "Query " << Index << ":\t";
-
-      assert("FIXME: Support counterexample query commands!");
-      if (QC->Values.empty() && QC->Objects.empty()) {
-        bool result;
-        if (S->mustBeTrue(Query(ConstraintManager(QC->Constraints), QC->Query),
-                          result)) {
-          llvm::outs() << (result ? "VALID" : "INVALID");
-        } else {
-          llvm::outs() << "FAIL (reason: "
-                    << SolverImpl::getOperationStatusString(S->impl->getOperationStatusCode())
-                    << ")";
-        }
-      } else if (!QC->Values.empty()) {
-        assert(QC->Objects.empty() && 
-               "FIXME: Support counterexamples for values and objects!");
-        assert(QC->Values.size() == 1 &&
-               "FIXME: Support counterexamples for multiple values!");
-        assert(QC->Query->isFalse() &&
-               "FIXME: Support counterexamples with non-trivial query!");
-        ref<ConstantExpr> result;
-        if (S->getValue(Query(ConstraintManager(QC->Constraints), 
-                              QC->Values[0]),
-                        result)) {
-          llvm::outs() << "INVALID\n";
-          llvm::outs() << "\tExpr 0:\t" << result;
-        } else {
-          llvm::outs() << "FAIL (reason: "
-                    << SolverImpl::getOperationStatusString(S->impl->getOperationStatusCode())
-                    << ")";
-        }
-      } else {
-        std::vector< std::vector<unsigned char> > result;
-        
-        if (S->getInitialValues(Query(ConstraintManager(QC->Constraints), 
-                                      QC->Query),
-                                QC->Objects, result)) {
-          llvm::outs() << "INVALID\n";
-
-          for (unsigned i = 0, e = result.size(); i != e; ++i) {
-            llvm::outs() << "\tArray " << i << ":\t"
-                       << QC->Objects[i]->name
-                       << "[";
-            for (unsigned j = 0; j != QC->Objects[i]->size; ++j) {
-              llvm::outs() << (unsigned) result[i][j];
-              if (j + 1 != QC->Objects[i]->size)
-                llvm::outs() << ", ";
-            }
-            llvm::outs() << "]";
-            if (i + 1 != e)
-              llvm::outs() << "\n";
-          }
-        } else {
-          SolverImpl::SolverRunStatus retCode = S->impl->getOperationStatusCode();
-          if (SolverImpl::SOLVER_RUN_STATUS_TIMEOUT == retCode) {
-            llvm::outs() << " FAIL (reason: "
-                      << SolverImpl::getOperationStatusString(retCode)
-                      << ")";
-          }           
-          else {
-            llvm::outs() << "VALID (counterexample request ignored)";
-          }
+/// Evaluates a query command, and prints its result (without the number
+/// of the query).
+static void EvaluateQuery(Solver *S, QueryCommand *QC, llvm::raw_ostream &os) {
+  assert("FIXME: Support counterexample query commands!");
+  if (QC->Values.empty() && QC->Objects.empty()) {
+    bool result;
+    if (S->mustBeTrue(Query(ConstraintManager(QC->Constraints), QC->Query),
+                      result)) {
+      os << (result ? "VALID" : "INVALID");
+    } else {
+      os << "FAIL (reason: "
+         << SolverImpl::getOperationStatusString(S->impl->getOperationStatusCode())
+         << ")";
+    }
+  } else if (!QC->Values.empty()) {
+    assert(QC->Objects.empty() && 
+           "FIXME: Support counterexamples for values and objects!");
+    assert(QC->Values.size() == 1 &&
+           "FIXME: Support counterexamples for multiple values!");
+    assert(QC->Query->isFalse() &&
+           "FIXME: Support counterexamples with non-trivial query!");
+    ref<ConstantExpr> result;
+    if (S->getValue(Query(ConstraintManager(QC->Constraints), 
+                          QC->Values[0]),
+                    result)) {
+      os << "INVALID\n";
+      os << "\tExpr 0:\t" << result;
+    } else {
+      os << "FAIL (reason: "
+         << SolverImpl::getOperationStatusString(S->impl->getOperationStatusCode())
+         << ")";
+    }
+  } else {
+    std::vector< std::vector<unsigned char> > result;
+    
+    if (S->getInitialValues(Query(ConstraintManager(QC->Constraints), 
+                                  QC->Query),
+                            QC->Objects, result)) {
+      os << "INVALID\n";
+
+      for (unsigned i = 0, e = result.size(); i != e; ++i) {
+        os << "\tArray " << i << ":\t"
+           << QC->Objects[i]->name
+           << "[";
+        for (unsigned j = 0; j != QC->Objects[i]->size; ++j) {
+          os << (unsigned) result[i][j];
+          if (j + 1 != QC->Objects[i]->size)
+            os << ", ";
         }
+        os << "]";
+        if (i + 1 != e)
+          os << "\n";
+      }
+    } else {
+      SolverImpl::SolverRunStatus retCode = S->impl->getOperationStatusCode();
+      if (SolverImpl::SOLVER_RUN_STATUS_TIMEOUT == retCode) {
+        os << " FAIL (reason: "
+           << SolverImpl::getOperationStatusString(retCode)
+           << ")";
+      }           
+      else {
+        os << "VALID (counterexample request ignored)";
       }
+    }
+  }
+}
 
-      llvm::outs() << "\n";
-      ++Index;
+/// Parses and evaluates the queries of a buffer one at a time, so that the
+/// memory does not grow with the size of the input. The results are either
+/// printed with their numbers, or terminated by a null character (for
+/// EvaluateInputInParts).
+static bool EvaluateQueries(const char *Filename, const MemoryBuffer *MB,
+                            ExprBuilder *Builder, Solver *S,
+                            llvm::raw_ostream &os, bool Numbered) {
+  Parser *P = Parser::Create(Filename, MB, Builder, ClearArrayAfterQuery);
+  P->SetMaxErrors(20);
+
+  unsigned Index = 0;
+  while (Decl *D = P->ParseTopLevelDecl()) {
+    /* nothing is evaluated after a parse error */
+    if (!P->GetNumErrors()) {
+      if (QueryCommand *QC = dyn_cast<QueryCommand>(D)) {
+        if (Numbered)
+          os << "Query " << Index << ":\t";
+        EvaluateQuery(S, QC, os);
+        os << (Numbered ? '\n' : '\0');
+        ++Index;
+      }
     }
+    delete D;
+  }
+
+  bool success = true;
+  if (unsigned N = P->GetNumErrors()) {
+    llvm::errs() << Filename << ": parse failure: " << N << " errors.\n";
+    success = false;
   }
 
-  for (std::vector<Decl*>::iterator it = Decls.begin(),
-         ie = Decls.end(); it != ie; ++it)
-    delete *it;
   delete P;
+  return success;
+}
+
+/// Finds the points where a query log can be split into (at most) the given
+/// number of parts of similar size. A part starts at a line which begins a
+/// query, together with the declarations and comments right above it, so
+/// each part can be parsed on its own if every query is preceded by the
+/// declarations of its arrays (as in the logs written by the solvers).
+static void SplitInput(const char *Begin, const char *End, unsigned NumParts,
+                       std::vector<const char*> &Starts) {
+  Starts.push_back(Begin);
+  for (unsigned i = 1; i < NumParts; i++) {
+    const char *Pos = Begin + (uint64_t) (End - Begin) * i / NumParts;
+    if (Pos <= Starts.back())
+      continue;
+
+    /* the next line which begins a query */
+    const char *Line = 0;
+    for (; Pos < End; Pos++) {
+      if (Pos[-1] != '\n')
+        continue;
+      if ((uint64_t) (End - Pos) >= 6 && !memcmp(Pos, "(query", 6)) {
+        Line = Pos;
+        break;
+      }
+    }
+    if (!Line)
+      break;
+
+    /* with the preceding declarations, comments and empty lines */
+    for (;;) {
+      const char *Prev = Line - 1;
+      while (Prev > Starts.back() && Prev[-1] != '\n')
+        Prev--;
+      if (Prev <= Starts.back())
+        break;
+      StringRef Text(Prev, Line - Prev);
+      if (!Text.startswith("array") && !Text.startswith("#") &&
+          !Text.trim().empty())
+        break;
+      Line = Prev;
+    }
+
+    if (Line > Starts.back())
+      Starts.push_back(Line);
+  }
+}
+
+/// Evaluates the parts of a query log in parallel, each by a forked process
+/// with its own solver, and prints their results in order.
+static bool EvaluateInputInParts(const char *Filename, const MemoryBuffer *MB,
+                                 ExprBuilder *Builder) {
+  std::vector<const char*> Starts;
+  SplitInput(MB->getBufferStart(), MB->getBufferEnd(), InputParts, Starts);
+  Starts.push_back(MB->getBufferEnd());
+
+  std::vector<FILE*> Results;
+  std::vector<pid_t> Children;
+  bool success = true;
+  llvm::outs().flush();
+  llvm::errs().flush();
+  for (unsigned i = 0; i + 1 < Starts.size(); i++) {
+    FILE *Result = tmpfile();
+    pid_t pid = Result ? fork() : -1;
+    if (pid < 0) {
+      llvm::errs() << Filename << ": error: unable to start part " << i
+                   << ": " << strerror(errno) << "\n";
+      if (Result)
+        fclose(Result);
+      success = false;
+      break;
+    }
 
+    if (pid == 0) {
+      llvm::raw_fd_ostream os(fileno(Result), false);
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+      OwningPtr<MemoryBuffer> Part(MemoryBuffer::getMemBuffer(
+          StringRef(Starts[i], Starts[i + 1] - Starts[i]), Filename, false));
+#else
+      std::unique_ptr<MemoryBuffer> Part(MemoryBuffer::getMemBuffer(
+          StringRef(Starts[i], Starts[i + 1] - Starts[i]), Filename, false));
+#endif
+      Solver *S = createSolverChain("." + llvm::utostr(i));
+      bool partSuccess = EvaluateQueries(Filename, Part.get(), Builder, S, os,
+                                         false);
+      delete S;
+      os.flush();
+      llvm::errs().flush();
+      _exit(partSuccess ? 0 : 1);
+    }
+
+    Results.push_back(Result);
+    Children.push_back(pid);
+  }
+
+  for (unsigned i = 0; i != Children.size(); i++) {
+    int status;
+    while (waitpid(Children[i], &status, 0) < 0 && errno == EINTR)
+      ;
+    if (!WIFEXITED(status) || WEXITSTATUS(status))
+      success = false;
+  }
+
+  /* the results are numbered across the parts */
+  unsigned Index = 0;
+  for (unsigned i = 0; i != Results.size(); i++) {
+    std::string Text;
+    char Buffer[4096];
+    rewind(Results[i]);
+    while (size_t n = fread(Buffer, 1, sizeof(Buffer), Results[i]))
+      Text.append(Buffer, n);
+    fclose(Results[i]);
+
+    for (size_t Pos = 0, Next; (Next = Text.find('\0', Pos)) !=
+           std::string::npos; Pos = Next + 1)
+      llvm::outs() << "Query " << Index++ << ":\t"
+                   << StringRef(Text.data() + Pos, Next - Pos) << "\n";
+  }
+
+  return success;
+}
+
+static bool EvaluateInputAST(const char *Filename,
+                             const MemoryBuffer *MB,
+                             ExprBuilder *Builder) {
+  /* a binary stream refers to its previous records, so it is not split;
+     the statistics of the parts are not collected */
+  if (InputParts > 1 && !serialization::isSerialized(MB->getBufferStart(),
+                                                     MB->getBufferEnd()))
+    return EvaluateInputInParts(Filename, MB, Builder);
+
+  Solver *S = createSolverChain("");
+  bool success = EvaluateQueries(Filename, MB, Builder, S, llvm::outs(), true);
   delete S;
+  if (!success)
+    return false;
 
   if (uint64_t queries = *theStatisticManager->getStatisticByName("Queries")) {
     llvm::outs()
@@ -406,15 +590,22 @@ int main(int argc, char **argv) {
 
   std::string ErrorStr;
   
+  // The input is not required to be null terminated, so that a file is
+  // always memory mapped (instead of read) when it is large.
 #if LLVM_VERSION_CODE < LLVM_VERSION(3,5)
   OwningPtr<MemoryBuffer> MB;
-  error_code ec=MemoryBuffer::getFileOrSTDIN(InputFile.c_str(), MB);
+  error_code ec;
+  if (InputFile == "-")
+    ec = MemoryBuffer::getSTDIN(MB);
+  else
+    ec = MemoryBuffer::getFile(InputFile, MB, -1, false);
   if (ec) {
     llvm::errs() << argv[0] << ": error: " << ec.message() << "\n";
     return 1;
   }
 #else
-  auto MBResult = MemoryBuffer::getFileOrSTDIN(InputFile.c_str());
+  auto MBResult = InputFile == "-" ?
+    MemoryBuffer::getSTDIN() : MemoryBuffer::getFile(InputFile, -1, false);
   if (!MBResult) {
     llvm::errs() << argv[0] << ": error: " << MBResult.getError().message()
                  << "\n";
@@ -447,6 +638,10 @@ int main(int argc, char **argv) {
     success = PrintInputAST(InputFile=="-" ? "<stdin>" : InputFile.c_str(), MB.get(),
                             Builder);
     break;
+  case WriteBinary:
+    success = WriteInputBinary(InputFile=="-" ? "<stdin>" : InputFile.c_str(),
+                               MB.get(), Builder);
+    break;
   case Evaluate:
     success = EvaluateInputAST(InputFile=="-" ? "<stdin>" : InputFile.c_str(),
                                MB.get(), Builder);
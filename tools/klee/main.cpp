@@ -17,7 +17,9 @@
 #include "klee/Internal/ADT/KTest.h"
 #include "klee/Internal/ADT/TreeStream.h"
 #include "klee/Internal/Support/Debug.h"
+#include "klee/Internal/Support/ModuleCache.h"
 #include "klee/Internal/Support/ModuleUtil.h"
+#include "klee/Internal/Support/PhaseTrace.h"
 #include "klee/Internal/System/Time.h"
 #include "klee/Internal/Support/PrintVersion.h"
 #include "klee/Internal/Support/ErrorHandling.h"
@@ -230,6 +232,14 @@ namespace {
 		cl::desc("Link the given libraries before execution"),
 		cl::value_desc("library file"));
 
+  cl::opt<std::string>
+  PreparedModuleCache("prepared-module-cache",
+                      cl::desc("Cache the linked and transformed module in "
+                               "the given directory, and reuse it when the "
+                               "input, the libraries and the relevant "
+                               "options are unchanged (default=off)"),
+                      cl::value_desc("directory"));
+
   cl::opt<unsigned>
   MakeConcreteSymbolic("make-concrete-symbolic",
                        cl::desc("Probabilistic rate at which to make concrete reads symbolic, "
@@ -475,6 +485,8 @@ llvm::raw_fd_ostream *KleeHandler::openTestFile(const std::string &suffix,
 void KleeHandler::processTestCase(const ExecutionState &state,
                                   const char *errorMessage,
                                   const char *errorSuffix) {
+  trace::PhaseScope tracePhase(trace::TestGeneration, &state);
+
   if (errorMessage && ExitOnError) {
     llvm::errs() << "EXITING ON ERROR:\n" << errorMessage << "\n";
     exit(1);
@@ -1075,6 +1087,92 @@ static char *format_tdiff(char *buf, long seconds)
   return buf;
 }
 
+/// Returns the path of the prepared module for the input and the options
+/// of this run, or an empty string if it can not be cached.
+static std::string getPreparedModulePath(const std::string &libDir) {
+  if (InputFile == "-")
+    return "";
+
+  ModuleCacheKey key;
+
+  /* the transformations are part of klee, so a rebuilt klee does not reuse
+     the modules prepared by the previous one */
+  struct stat st;
+  if (stat("/proc/self/exe", &st) == 0) {
+    std::stringstream ss;
+    ss << st.st_size << " " << st.st_mtime;
+    key.addString(ss.str());
+  }
+
+  std::vector<std::string> files;
+  files.push_back(InputFile);
+
+  SmallString<128> path(libDir);
+  switch (Libc) {
+  case NoLibc:
+    break;
+  case KleeLibc:
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3,3)
+    llvm::sys::path::append(path, "klee-libc.bc");
+#else
+    llvm::sys::path::append(path, "libklee-libc.bca");
+#endif
+    files.push_back(path.str());
+    break;
+  case UcLibc:
+#ifdef SUPPORT_KLEE_UCLIBC
+    llvm::sys::path::append(path, KLEE_UCLIBC_BCA_NAME);
+    files.push_back(path.str());
+#endif
+    break;
+  }
+
+  if (WithPOSIXRuntime) {
+    path = libDir;
+    llvm::sys::path::append(path, "libkleeRuntimePOSIX.bca");
+    files.push_back(path.str());
+  }
+
+  path = libDir;
+#if LLVM_VERSION_CODE >= LLVM_VERSION(3,3)
+  llvm::sys::path::append(path, "kleeRuntimeIntrinsic.bc");
+#else
+  llvm::sys::path::append(path, "libkleeRuntimeIntrinsic.bca");
+#endif
+  files.push_back(path.str());
+
+  files.insert(files.end(), LinkLibraries.begin(), LinkLibraries.end());
+
+  for (std::vector<std::string>::iterator it = files.begin(),
+         ie = files.end(); it != ie; ++it) {
+    if (!key.addFile(*it)) {
+      klee_warning("unable to read %s, the module is not cached",
+                   it->c_str());
+      return "";
+    }
+  }
+
+  std::stringstream options;
+  options << "libc=" << (int) Libc << "\n"
+          << "posix-runtime=" << WithPOSIXRuntime << "\n"
+          << "sym-arg-runtime=" << WithSymArgsRuntime << "\n"
+          << "entry-point=" << EntryPoint << "\n"
+          << "optimize=" << OptimizeModule << "\n"
+          << "check-div-zero=" << CheckDivZero << "\n"
+          << "check-overshift=" << CheckOvershift << "\n"
+          << "skip-functions=" << SkippedFunctions << "\n"
+          << getModuleTransformOptions();
+  key.addString(options.str());
+
+  if (mkdir(PreparedModuleCache.c_str(), 0775) != 0 && errno != EEXIST) {
+    klee_warning("unable to create the module cache directory %s: %s",
+                 PreparedModuleCache.c_str(), strerror(errno));
+    return "";
+  }
+
+  return key.getPath(PreparedModuleCache);
+}
+
 #ifndef SUPPORT_KLEE_UCLIBC
 static llvm::Module *linkWithUclibc(llvm::Module *mainModule, StringRef libDir) {
   klee_error("invalid libc, no uclibc support!\n");
@@ -1381,103 +1479,121 @@ int main(int argc, char **argv, char **envp) {
 
   sys::SetInterruptFunction(interrupt_handle);
 
-  // Load the bytecode...
-  std::string ErrorMsg;
+  std::string LibraryDir = KleeHandler::getRunTimeLibraryPath(argv[0]);
+  Interpreter::ModuleOptions Opts(LibraryDir.c_str(), EntryPoint,
+                                  /*Optimize=*/OptimizeModule,
+                                  /*CheckDivZero=*/CheckDivZero,
+                                  /*CheckOvershift=*/CheckOvershift);
+
   Module *mainModule = 0;
+  if (!PreparedModuleCache.empty()) {
+    std::string path = getPreparedModulePath(LibraryDir);
+    if (!path.empty()) {
+      mainModule = loadCachedModule(path, getGlobalContext());
+      if (mainModule) {
+        klee_message("NOTE: Using the prepared module %s", path.c_str());
+        Opts.Prepared = true;
+      } else {
+        Opts.PreparedModuleCache = path;
+      }
+    }
+  }
+
 #if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
   OwningPtr<MemoryBuffer> BufferPtr;
-  error_code ec=MemoryBuffer::getFileOrSTDIN(InputFile.c_str(), BufferPtr);
-  if (ec) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               ec.message().c_str());
-  }
+#endif
+  if (!mainModule) {
+    // Load the bytecode...
+    std::string ErrorMsg;
+#if LLVM_VERSION_CODE < LLVM_VERSION(3, 5)
+    error_code ec=MemoryBuffer::getFileOrSTDIN(InputFile.c_str(), BufferPtr);
+    if (ec) {
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 ec.message().c_str());
+    }
 
-  mainModule = getLazyBitcodeModule(BufferPtr.get(), getGlobalContext(), &ErrorMsg);
+    mainModule = getLazyBitcodeModule(BufferPtr.get(), getGlobalContext(), &ErrorMsg);
 
-  if (mainModule) {
-    if (mainModule->MaterializeAllPermanently(&ErrorMsg)) {
-      delete mainModule;
-      mainModule = 0;
+    if (mainModule) {
+      if (mainModule->MaterializeAllPermanently(&ErrorMsg)) {
+        delete mainModule;
+        mainModule = 0;
+      }
     }
-  }
-  if (!mainModule)
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               ErrorMsg.c_str());
+    if (!mainModule)
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 ErrorMsg.c_str());
 #else
-  auto Buffer = MemoryBuffer::getFileOrSTDIN(InputFile.c_str());
-  if (!Buffer)
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               Buffer.getError().message().c_str());
+    auto Buffer = MemoryBuffer::getFileOrSTDIN(InputFile.c_str());
+    if (!Buffer)
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 Buffer.getError().message().c_str());
 
-  auto mainModuleOrError = getLazyBitcodeModule(Buffer->get(), getGlobalContext());
+    auto mainModuleOrError = getLazyBitcodeModule(Buffer->get(), getGlobalContext());
 
-  if (!mainModuleOrError) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               mainModuleOrError.getError().message().c_str());
-  }
-  else {
-    // The module has taken ownership of the MemoryBuffer so release it
-    // from the std::unique_ptr
-    Buffer->release();
-  }
+    if (!mainModuleOrError) {
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 mainModuleOrError.getError().message().c_str());
+    }
+    else {
+      // The module has taken ownership of the MemoryBuffer so release it
+      // from the std::unique_ptr
+      Buffer->release();
+    }
 
-  mainModule = *mainModuleOrError;
-  if (auto ec = mainModule->materializeAllPermanently()) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               ec.message().c_str());
-  }
+    mainModule = *mainModuleOrError;
+    if (auto ec = mainModule->materializeAllPermanently()) {
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 ec.message().c_str());
+    }
 #endif
 
-  if (WithPOSIXRuntime || WithSymArgsRuntime) {
-    int r = initEnv(mainModule);
-    if (r != 0)
-      return r;
-  }
-
-  std::string LibraryDir = KleeHandler::getRunTimeLibraryPath(argv[0]);
-  Interpreter::ModuleOptions Opts(LibraryDir.c_str(), EntryPoint,
-                                  /*Optimize=*/OptimizeModule,
-                                  /*CheckDivZero=*/CheckDivZero,
-                                  /*CheckOvershift=*/CheckOvershift);
+    if (WithPOSIXRuntime || WithSymArgsRuntime) {
+      int r = initEnv(mainModule);
+      if (r != 0)
+        return r;
+    }
 
-  switch (Libc) {
-  case NoLibc: /* silence compiler warning */
-    break;
+    switch (Libc) {
+    case NoLibc: /* silence compiler warning */
+      break;
 
-  case KleeLibc: {
-    // FIXME: Find a reasonable solution for this.
-    SmallString<128> Path(Opts.LibraryDir);
+    case KleeLibc: {
+      // FIXME: Find a reasonable solution for this.
+      SmallString<128> Path(Opts.LibraryDir);
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3,3)
-    llvm::sys::path::append(Path, "klee-libc.bc");
+      llvm::sys::path::append(Path, "klee-libc.bc");
 #else
-    llvm::sys::path::append(Path, "libklee-libc.bca");
+      llvm::sys::path::append(Path, "libklee-libc.bca");
 #endif
-    mainModule = klee::linkWithLibrary(mainModule, Path.c_str());
-    assert(mainModule && "unable to link with klee-libc");
-    break;
-  }
+      mainModule = klee::linkWithLibrary(mainModule, Path.c_str());
+      assert(mainModule && "unable to link with klee-libc");
+      break;
+    }
 
-  case UcLibc:
-    mainModule = linkWithUclibc(mainModule, LibraryDir);
-    break;
-  }
+    case UcLibc:
+      mainModule = linkWithUclibc(mainModule, LibraryDir);
+      break;
+    }
 
-  if (WithPOSIXRuntime) {
-    SmallString<128> Path(Opts.LibraryDir);
-    llvm::sys::path::append(Path, "libkleeRuntimePOSIX.bca");
-    klee_message("NOTE: Using model: %s", Path.c_str());
-    mainModule = klee::linkWithLibrary(mainModule, Path.c_str());
-    assert(mainModule && "unable to link with simple model");
-  }
+    if (WithPOSIXRuntime) {
+      SmallString<128> Path(Opts.LibraryDir);
+      llvm::sys::path::append(Path, "libkleeRuntimePOSIX.bca");
+      klee_message("NOTE: Using model: %s", Path.c_str());
+      mainModule = klee::linkWithLibrary(mainModule, Path.c_str());
+      assert(mainModule && "unable to link with simple model");
+    }
 
-  std::vector<std::string>::iterator libs_it;
-  std::vector<std::string>::iterator libs_ie;
-  for (libs_it = LinkLibraries.begin(), libs_ie = LinkLibraries.end();
-          libs_it != libs_ie; ++libs_it) {
-    const char * libFilename = libs_it->c_str();
-    klee_message("Linking in library: %s.\n", libFilename);
-    mainModule = klee::linkWithLibrary(mainModule, libFilename);
+    std::vector<std::string>::iterator libs_it;
+    std::vector<std::string>::iterator libs_ie;
+    for (libs_it = LinkLibraries.begin(), libs_ie = LinkLibraries.end();
+            libs_it != libs_ie; ++libs_it) {
+      const char * libFilename = libs_it->c_str();
+      klee_message("Linking in library: %s.\n", libFilename);
+      mainModule = klee::linkWithLibrary(mainModule, libFilename);
+    }
   }
+
   // Get the desired main function.  klee_main initializes uClibc
   // locale and other data and then calls main.
   Function *mainFn = mainModule->getFunction(EntryPoint);